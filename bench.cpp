@@ -0,0 +1,356 @@
+// Benchmark harness for the TODO app's hot paths.
+//
+// Synthesizes todo.db / notifications.db at several task counts in a scratch
+// directory, then times snapshot load, notification load, the filter pass,
+// snapshot save, and a scripted redraw loop. Output is one CSV line per
+// measurement on stdout:
+//
+//   bench,tasks,iters,total_ms,per_iter_us
+//
+// so runs can be diffed mechanically across commits. Build with `make bench`;
+// run with no arguments for the default 1k/10k/100k/1M sweep, or pass task
+// counts explicitly: ./bench 1000 50000
+//
+// Interactive latency measurements are a second line shape:
+//
+//   lat,<op>,<tasks>,<events>,<p50_us>,<p90_us>,<p99_us>,<max_us>
+//
+// These drive the real dispatchKey() path with scripted input injected
+// through ungetch() — held-arrow scrolling, completeTask, editTask and the
+// filter overlay — and report per-event keypress-to-paint percentiles, so
+// caching/dirty-redraw changes get a pass/fail gate instead of eyeballing.
+//
+// The redraw and latency loops drive the real ncurses draw code against a
+// terminal opened on /dev/null, so they measure our layout/paint work
+// without a TTY (terminal emulator cost is out of scope either way).
+
+#define TODO_BENCH
+#include "todo.cpp"
+
+#include <cstdio>
+
+using BenchClock = std::chrono::steady_clock;
+
+static double elapsedMs(BenchClock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(BenchClock::now() - t0)
+        .count();
+}
+
+static void report(const char* name, size_t tasks, int iters, double totalMs) {
+    std::printf("%s,%zu,%d,%.3f,%.3f\n", name, tasks, iters, totalMs,
+                totalMs * 1000.0 / iters);
+    std::fflush(stdout);
+}
+
+static const char* const BENCH_CATEGORIES[] = {
+    "", "work", "home", "errands", "health", "finance", "reading", "misc",
+};
+static const char* const BENCH_WORDS[] = {
+    "review", "the", "quarterly", "report", "and", "send", "feedback",
+    "buy", "groceries", "for", "dinner", "party", "schedule", "dentist",
+    "appointment", "fix", "leaking", "tap", "in", "bathroom",
+};
+
+// Build a deterministic in-memory task set of size n and write it out
+// through the production serializers, so load benchmarks read exactly what
+// the app would have written.
+static void synthesize(size_t n) {
+    allTasks.clear();
+    allTasks.reserve(n);
+    notifications.clear();
+
+    const size_t numWords = sizeof(BENCH_WORDS) / sizeof(BENCH_WORDS[0]);
+    const size_t numCats = sizeof(BENCH_CATEGORIES) / sizeof(BENCH_CATEGORIES[0]);
+
+    for (size_t i = 0; i < n; i++) {
+        Task t;
+        t.id = (long long)(i + 1);
+        t.dates[0] = 1700000000LL + (long long)i;
+        // Roughly a quarter completed, like a lived-in DB
+        t.completed = (i % 4 == 0);
+        t.dates[1] = t.completed ? t.dates[0] + 3600 : 0;
+        t.categoryId = internCategory(BENCH_CATEGORIES[i % numCats]);
+
+        // 3-7 word task text, varying with i so strings differ in length
+        size_t wordCount = 3 + i % 5;
+        for (size_t w = 0; w < wordCount; w++) {
+            if (w) t.task += ' ';
+            t.task += BENCH_WORDS[(i + w * 7) % numWords];
+        }
+
+        // A sprinkling of reminders
+        if (i % 16 == 0) {
+            t.notification.scheduledTime = t.dates[0] + 86400;
+            t.notification.triggered = false;
+            t.notification.taskId = t.id;
+            t.notification.message = t.task;
+            notifications[t.id] = t.notification;
+        }
+        allTasks.push_back(std::move(t));
+    }
+    nextTaskId = (long long)n + 1;
+
+    saveTasks();
+    saveNotifications();
+}
+
+static void benchLoad(size_t n) {
+    // First load is the interesting one (cold caches within the process),
+    // but average a few iterations so 1k isn't pure noise.
+    int iters = (n >= 100000) ? 3 : 10;
+    auto t0 = BenchClock::now();
+    for (int i = 0; i < iters; i++) {
+        allTasks = loadTasksFromFile();
+    }
+    report("loadTasksFromFile", n, iters, elapsedMs(t0));
+
+    t0 = BenchClock::now();
+    for (int i = 0; i < iters; i++) {
+        loadNotifications();
+    }
+    report("loadNotifications", n, iters, elapsedMs(t0));
+}
+
+static void benchFilter(size_t n) {
+    rebuildViews();
+    activeFilterCategory = "work";
+    activeFilterCatId = internCategory("work");
+
+    int iters = (n >= 100000) ? 20 : 200;
+    auto t0 = BenchClock::now();
+    for (int i = 0; i < iters; i++) {
+        // Invalidate each round: we are measuring the rebuild, not the cache
+        invalidateFilterIndex();
+        (void)getFilteredIndices();
+    }
+    report("filterRebuild", n, iters, elapsedMs(t0));
+
+    t0 = BenchClock::now();
+    for (int i = 0; i < iters; i++) {
+        (void)getFilteredIndices(); // cached path
+    }
+    report("filterCached", n, iters, elapsedMs(t0));
+
+    activeFilterCategory = "All";
+    activeFilterCatId = -1;
+    invalidateFilterIndex();
+}
+
+static void benchSave(size_t n) {
+    int iters = (n >= 100000) ? 3 : 10;
+    auto t0 = BenchClock::now();
+    for (int i = 0; i < iters; i++) {
+        saveTasks();
+    }
+    report("saveTasks", n, iters, elapsedMs(t0));
+}
+
+// Shared ncurses-on-/dev/null screen for the redraw and latency suites.
+static SCREEN* benchScreen = nullptr;
+static FILE* benchScreenOut = nullptr;
+static FILE* benchScreenIn = nullptr;
+
+static bool openBenchScreen() {
+    benchScreenOut = std::fopen("/dev/null", "w");
+    benchScreenIn = std::fopen("/dev/null", "r");
+    benchScreen = (benchScreenOut && benchScreenIn)
+                      ? newterm("xterm", benchScreenOut, benchScreenIn)
+                      : nullptr;
+    if (!benchScreen) {
+        // No usable terminfo; skip rather than fail the whole run
+        if (benchScreenOut) std::fclose(benchScreenOut);
+        if (benchScreenIn) std::fclose(benchScreenIn);
+        std::fprintf(stderr, "bench: newterm failed, skipping screen suite\n");
+        return false;
+    }
+    start_color();
+    init_pair(1, COLOR_GREEN, COLOR_BLACK);
+    init_pair(2, COLOR_BLACK, COLOR_WHITE);
+    init_pair(3, COLOR_BLUE, COLOR_BLACK);
+
+    int listStartY = 8;
+    int listHeight = LINES - listStartY - 2;
+    listWin = newwin(listHeight, COLS - 4, listStartY, 2);
+    keypad(stdscr, true);
+    return true;
+}
+
+static void closeBenchScreen() {
+    delwin(listWin);
+    listWin = nullptr;
+    endwin();
+    delscreen(benchScreen);
+    benchScreen = nullptr;
+    std::fclose(benchScreenOut);
+    std::fclose(benchScreenIn);
+}
+
+static void benchRedraw(size_t n) {
+    if (!openBenchScreen()) return;
+
+    rebuildViews();
+    selectedIndex = 0;
+
+    // Scripted scroll: step the selection through the list the way held-down
+    // KEY_DOWN would, redrawing each step (exercises the dirty-row fast path
+    // and the scroll repaints).
+    int iters = 500;
+    int limit = (int)getFilteredIndices().size();
+    auto t0 = BenchClock::now();
+    for (int i = 0; i < iters; i++) {
+        if (limit > 1) selectedIndex = i % limit;
+        drawUI();
+        doupdate();
+    }
+    report("redrawScroll", n, iters, elapsedMs(t0));
+
+    // Full repaints (what an overlay close or resize costs)
+    iters = 100;
+    t0 = BenchClock::now();
+    for (int i = 0; i < iters; i++) {
+        invalidateListUI();
+        drawUI();
+        doupdate();
+    }
+    report("redrawFull", n, iters, elapsedMs(t0));
+
+    closeBenchScreen();
+}
+
+// ---------------------------------------------------------------------------
+// Interactive latency suite.
+// ---------------------------------------------------------------------------
+
+static void reportLatency(const char* name, size_t tasks,
+                          std::vector<long long>& us) {
+    if (us.empty()) return;
+    std::sort(us.begin(), us.end());
+    auto pct = [&us](double p) {
+        size_t i = (size_t)(p * (double)us.size());
+        if (i >= us.size()) i = us.size() - 1;
+        return us[i];
+    };
+    std::printf("lat,%s,%zu,%zu,%lld,%lld,%lld,%lld\n", name, tasks,
+                us.size(), pct(0.50), pct(0.90), pct(0.99), us.back());
+    std::fflush(stdout);
+}
+
+// Inject one key (plus any keys an overlay will consume after it) into the
+// ncurses input queue and run the real dispatch path. ungetch() is the
+// injectable input source: every window's wgetch() reads the same queue, so
+// overlays consume the scripted keys exactly as they would a user's.
+// Returns keypress-to-paint time in microseconds.
+static long long dispatchOne(int key, std::initializer_list<int> overlayKeys = {}) {
+    // ungetch is a stack: push the overlay keys in reverse, the trigger last
+    for (auto it = std::rbegin(overlayKeys); it != std::rend(overlayKeys); ++it) {
+        ungetch(*it);
+    }
+    ungetch(key);
+
+    int ch = wgetch(stdscr);
+    long long t0 = perfNowUs();
+    bool running = true;
+    bool needRedraw = false;
+    dispatchKey(ch, running, needRedraw);
+    if (needRedraw) {
+        drawUI();
+        doupdate();
+    }
+    return perfNowUs() - t0;
+}
+
+static void benchInteractive(size_t n) {
+    if (!openBenchScreen()) return;
+
+    rebuildViews();
+    // The regression scenario: a category filter active while interacting
+    activeFilterCategory = "work";
+    activeFilterCatId = internCategory("work");
+    invalidateFilterIndex();
+    selectedIndex = 0;
+    markedTaskIds.clear();
+    drawUI();
+    doupdate();
+
+    // Journal writes happen off-thread in the interactive app; measure the
+    // same enqueue cost, not a synchronous fsync per keypress.
+    startJournalThread();
+
+    std::vector<long long> us;
+
+    // Held KEY_DOWN: per-event keypress-to-paint while scrolling. (The real
+    // loop coalesces bursts; this measures the worst case of one paint per
+    // event, which is what the dirty-row path keeps flat.)
+    int avail = (int)getFilteredIndices().size();
+    int events = std::min(500, avail > 1 ? avail - 1 : 1);
+    for (int i = 0; i < events; i++) {
+        us.push_back(dispatchOne(KEY_DOWN));
+    }
+    reportLatency("scrollFiltered", n, us);
+
+    selectedIndex = 0;
+    us.clear();
+    int iters = std::min(200, avail > 1 ? avail - 1 : 0);
+    for (int i = 0; i < iters; i++) {
+        us.push_back(dispatchOne('c'));
+    }
+    reportLatency("completeTask", n, us);
+
+    // editTask: the overlay types one character and confirms with Enter;
+    // alternating insert/backspace keeps the text length stable across runs
+    selectedIndex = 0;
+    us.clear();
+    for (int i = 0; i < 100; i++) {
+        us.push_back(dispatchOne('e', {(i & 1) ? 127 : 'x', '\n'}));
+    }
+    reportLatency("editTask", n, us);
+
+    // Filter overlay: alternate between picking the first real category
+    // (cursor down + Enter) and resetting to "All" (Enter on the top row)
+    us.clear();
+    for (int i = 0; i < 100; i++) {
+        if (i & 1) {
+            us.push_back(dispatchOne('#', {'\n'}));
+        } else {
+            us.push_back(dispatchOne('#', {KEY_DOWN, '\n'}));
+        }
+    }
+    reportLatency("filterOverlay", n, us);
+
+    stopJournalThread();
+
+    activeFilterCategory = "All";
+    activeFilterCatId = -1;
+    invalidateFilterIndex();
+    markedTaskIds.clear();
+    closeBenchScreen();
+}
+
+int main(int argc, char** argv) {
+    if (!std::getenv("TODO_DATA_DIR")) {
+        std::fprintf(stderr,
+                     "bench: set TODO_DATA_DIR to a scratch directory "
+                     "(refusing to clobber /var/lib/todo)\n");
+        return 1;
+    }
+
+    std::vector<size_t> sizes;
+    if (argc > 1) {
+        for (int i = 1; i < argc; i++) {
+            sizes.push_back((size_t)std::stoull(argv[i]));
+        }
+    } else {
+        sizes = {1000, 10000, 100000, 1000000};
+    }
+
+    std::printf("bench,tasks,iters,total_ms,per_iter_us\n");
+    for (size_t n : sizes) {
+        synthesize(n);
+        benchLoad(n);
+        benchFilter(n);
+        benchSave(n);
+        benchRedraw(n);
+        benchInteractive(n);
+    }
+    return 0;
+}
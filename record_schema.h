@@ -0,0 +1,231 @@
+// Shared record schema for the TUI and the daemon.
+//
+// The on-disk formats used to be hand-rolled in four places — the task
+// snapshot reader/writer in todo.cpp and a loadNotifications/saveNotifications
+// pair duplicated into each binary — which is exactly how the two halves
+// drift apart. Each record layout is now declared once as a compile-time
+// field list (a constexpr tuple of accessors), and the reader and writer are
+// generated from the same list by walking it with a fold expression. The
+// compiler sees a flat sequence of fixed-size loads/stores, and a field can
+// only be added by touching the one list both sides compile against.
+//
+// Two encodings share the field-list machinery:
+//   - raw binary: each field's bytes back to back (bool as one byte), used
+//     for the task snapshot payload inside its length/CRC frame
+//   - text lines: "<numeric fields>;...;<message>" — the list gives the
+//     numeric prefix in file order and the free-text message is always the
+//     final field, used for notifications.db and the daemon's IPC tail
+#ifndef RECORD_SCHEMA_H
+#define RECORD_SCHEMA_H
+
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// Represents a single notification
+struct Notification {
+    long long scheduledTime = 0;   // Unix epoch when the notification should fire
+    bool triggered = false;        // Has the notification been triggered already?
+    long long repeatInterval = 0;  // Seconds between occurrences; 0 = one-shot
+    int repeatWeekdays = 0;        // Bitmask bit0=Sun..bit6=Sat; 0 = any day
+    long long taskId = 0;          // Owning task's id; 0 = unkeyed legacy entry
+    std::string message;           // The text of the notification
+};
+
+namespace schema {
+
+// Fields are accessor lambdas rather than pointers-to-member so a list can
+// reach into arrays and nested structs (dates[0], notification.scheduledTime)
+// with the same machinery as plain members.
+constexpr auto NOTIFICATION_FIELDS = std::make_tuple(
+    [](auto& n) -> auto& { return n.scheduledTime; },
+    [](auto& n) -> auto& { return n.triggered; },
+    [](auto& n) -> auto& { return n.repeatInterval; },
+    [](auto& n) -> auto& { return n.repeatWeekdays; },
+    [](auto& n) -> auto& { return n.taskId; });
+
+// Field index where the daemon's ADD IPC tail starts (it carries its own
+// scheduledTime up front and no triggered flag).
+constexpr std::size_t NOTIFICATION_TAIL_FIELD = 2;
+
+// Numeric-prefix lengths that have ever shipped for a text record: 5 is
+// current, 4 the pre-taskId format, 2 the original "time;flag;message"
+// lines. The parser only tries these (the IPC tail sees them offset by
+// the fields the ADD verb carries itself); trying a count no writer ever
+// produced would let a message that happens to start with "<digits>;"
+// be eaten as the phantom extra field of that shape.
+constexpr bool shippedTextPrefix(std::size_t nFields) {
+    return nFields == 5 || nFields == 4 || nFields == 2;
+}
+
+// ---------------------------------------------------------------------------
+// Raw binary encoding.
+// ---------------------------------------------------------------------------
+
+inline void appendRawField(std::string& buf, bool v) {
+    uint8_t b = v ? 1 : 0;
+    buf.append(reinterpret_cast<const char*>(&b), 1);
+}
+
+template <typename T>
+inline void appendRawField(std::string& buf, const T& v) {
+    static_assert(std::is_trivially_copyable_v<T>,
+                  "raw fields must be memcpy-safe");
+    buf.append(reinterpret_cast<const char*>(&v), sizeof(T));
+}
+
+inline bool readRawField(const char*& p, const char* end, bool& v) {
+    if (end - p < 1) return false;
+    v = (*p != 0);
+    p += 1;
+    return true;
+}
+
+// memcpy so we never do unaligned loads from an mmap'd file.
+template <typename T>
+inline bool readRawField(const char*& p, const char* end, T& v) {
+    if ((std::size_t)(end - p) < sizeof(T)) return false;
+    std::memcpy(&v, p, sizeof(T));
+    p += sizeof(T);
+    return true;
+}
+
+namespace detail {
+
+template <typename Rec, typename Tuple, std::size_t... I>
+void appendRecordFieldsImpl(std::string& buf, const Rec& r, const Tuple& t,
+                            std::index_sequence<I...>) {
+    (appendRawField(buf, std::get<I>(t)(r)), ...);
+}
+
+template <typename Rec, typename Tuple, std::size_t... I>
+bool parseRecordFieldsImpl(const char*& p, const char* end, Rec& r,
+                           const Tuple& t, std::index_sequence<I...>) {
+    return (readRawField(p, end, std::get<I>(t)(r)) && ...);
+}
+
+}  // namespace detail
+
+template <typename Rec, typename Tuple>
+void appendRecordFields(std::string& buf, const Rec& r, const Tuple& t) {
+    detail::appendRecordFieldsImpl(
+        buf, r, t, std::make_index_sequence<std::tuple_size_v<Tuple>>{});
+}
+
+template <typename Rec, typename Tuple>
+bool parseRecordFields(const char*& p, const char* end, Rec& r,
+                       const Tuple& t) {
+    return detail::parseRecordFieldsImpl(
+        p, end, r, t, std::make_index_sequence<std::tuple_size_v<Tuple>>{});
+}
+
+// ---------------------------------------------------------------------------
+// Text-line encoding.
+// ---------------------------------------------------------------------------
+
+inline void appendFieldText(std::string& out, bool v) { out += v ? '1' : '0'; }
+inline void appendFieldText(std::string& out, int v) { out += std::to_string(v); }
+inline void appendFieldText(std::string& out, long long v) {
+    out += std::to_string(v);
+}
+
+inline bool parseFieldToken(const char* b, const char* e, bool& v) {
+    if (e - b != 1 || (*b != '0' && *b != '1')) return false;
+    v = (*b == '1');
+    return true;
+}
+
+// The whole token must be numeric — a partial match means this isn't a
+// field at all but the start of the free-text message.
+template <typename T>
+inline bool parseFieldToken(const char* b, const char* e, T& v) {
+    auto res = std::from_chars(b, e, v);
+    return res.ec == std::errc() && res.ptr == e;
+}
+
+namespace detail {
+
+template <std::size_t First, typename Rec, typename Tuple, std::size_t... I>
+void formatTextFieldsImpl(std::string& out, const Rec& r, const Tuple& t,
+                          std::index_sequence<I...>) {
+    ((appendFieldText(out, std::get<First + I>(t)(r)), out += ';'), ...);
+}
+
+template <typename Rec, typename Acc>
+bool parseOneTextField(const std::string& s, std::size_t& pos, Rec& r,
+                       const Acc& acc) {
+    std::size_t sep = s.find(';', pos);
+    if (sep == std::string::npos) return false;
+    if (!parseFieldToken(s.data() + pos, s.data() + sep, acc(r))) return false;
+    pos = sep + 1;
+    return true;
+}
+
+template <std::size_t First, typename Rec, typename Tuple, std::size_t... I>
+bool tryParseExact(const std::string& s, Rec& r, const Tuple& t,
+                   std::size_t& msgPos, std::index_sequence<I...>) {
+    Rec tmp = r;
+    std::size_t pos = 0;
+    if ((parseOneTextField(s, pos, tmp, std::get<First + I>(t)) && ...)) {
+        r = std::move(tmp);
+        msgPos = pos;
+        return true;
+    }
+    return false;
+}
+
+// Longest shipped all-numeric prefix wins: try the full field count, then
+// each shorter count that a past generation of the format actually wrote.
+// That is how lines written by older generations (fewer fields before the
+// message) keep loading — the missing trailing fields simply keep their
+// defaults — without counts that never existed stealing a digits-led
+// message prefix.
+template <std::size_t First, std::size_t Count, typename Rec, typename Tuple>
+std::size_t tryParsePrefix(const std::string& s, Rec& r, const Tuple& t,
+                           std::size_t& msgPos) {
+    if constexpr (Count == 0) {
+        msgPos = 0;
+        return 0;  // bare message
+    } else {
+        if (shippedTextPrefix(First + Count) &&
+            tryParseExact<First>(s, r, t, msgPos,
+                                 std::make_index_sequence<Count>{})) {
+            return Count;
+        }
+        return tryParsePrefix<First, Count - 1>(s, r, t, msgPos);
+    }
+}
+
+}  // namespace detail
+
+// Append fields [First..) of the list, each ';'-terminated, then the message.
+template <std::size_t First = 0, typename Rec, typename Tuple>
+void formatTextRecord(std::string& out, const Rec& r, const Tuple& t,
+                      const std::string& message) {
+    detail::formatTextFieldsImpl<First>(
+        out, r, t,
+        std::make_index_sequence<std::tuple_size_v<Tuple> - First>{});
+    out += message;
+}
+
+// Parse counterpart. Returns how many fields matched so the caller can
+// enforce its own minimum (a notifications.db line needs at least the
+// timestamp and flag; the IPC tail accepts any suffix).
+template <std::size_t First = 0, typename Rec, typename Tuple>
+std::size_t parseTextRecord(const std::string& s, Rec& r, const Tuple& t,
+                            std::string& message) {
+    std::size_t msgPos = 0;
+    std::size_t matched =
+        detail::tryParsePrefix<First, std::tuple_size_v<Tuple> - First>(
+            s, r, t, msgPos);
+    message = s.substr(msgPos);
+    return matched;
+}
+
+}  // namespace schema
+
+#endif  // RECORD_SCHEMA_H
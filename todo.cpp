@@ -2,55 +2,189 @@
 #include <fstream>
 #include <string>
 #include <vector>
+#include <array>
 #include <chrono>
 #include <iomanip>
 #include <sstream>
-#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <map>
+#include <deque>
+#include <limits>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 #include <cctype>
+#include <cerrno>
+#include <charconv>
 #include <wchar.h>
 #include <algorithm>
 #include <ncurses.h>
 #include <ctime>
 #include <filesystem>
 #include <cstdlib>
+#include <cstdint>
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/file.h>
+#include <sys/inotify.h>
+#include <sys/wait.h>
 #include <unistd.h>
 
+#include "record_schema.h"
+
 #include <cstring>
 namespace fs = std::filesystem;
 
-static const std::string NOTIFICATION_FILE = "/var/lib/todo/notifications.db";
-static const std::string TODO_FILE = "/var/lib/todo/todo.db";
+// Data directory. TODO_DATA_DIR lets the benchmark harness (or a cautious
+// user) point the app at a scratch tree instead of /var/lib/todo.
+static std::string dataDir() {
+    const char* env = std::getenv("TODO_DATA_DIR");
+    return env ? env : "/var/lib/todo";
+}
+static const std::string NOTIFICATION_FILE = dataDir() + "/notifications.db";
+static const std::string TODO_FILE = dataDir() + "/todo.db";
+static const std::string JOURNAL_FILE = dataDir() + "/todo.journal";
+static const std::string DAEMON_SOCKET = dataDir() + "/todo.sock";
+
+// Serializes TUI and daemon access to the shared files in the data dir.
+// flock on a sidecar file rather than the data files themselves: the
+// rename-swap in atomicWriteFile replaces inodes, which would silently
+// drop a lock taken on the old one.
+static int acquireDataLock(int op) {
+    int fd = open((dataDir() + "/todo.lock").c_str(), O_RDONLY | O_CREAT, 0664);
+    if (fd >= 0) flock(fd, op);
+    return fd;
+}
 
-// Represents a single notification
-struct Notification {
-    long long scheduledTime;  // Unix epoch when the notification should fire
-    bool triggered;           // Has the notification been triggered already?
-    std::string message;      // The text of the notification
-};
+static void releaseDataLock(int fd) {
+    if (fd >= 0) close(fd); // closing drops the flock
+}
+
+// Crash-safe file replacement: write to a temp file in the same directory,
+// fsync it, then rename over the original. Readers see either the old
+// complete file or the new complete file, never a truncated mix.
+static bool atomicWriteFile(const std::string& path, const std::string& buf) {
+    std::string tmp = path + ".tmp";
+    int fd = open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0664);
+    if (fd < 0) return false;
+
+    size_t off = 0;
+    while (off < buf.size()) {
+        ssize_t n = write(fd, buf.data() + off, buf.size() - off);
+        if (n <= 0) {
+            close(fd);
+            unlink(tmp.c_str());
+            return false; // disk full etc.; the original is untouched
+        }
+        off += (size_t)n;
+    }
+    if (fsync(fd) != 0) {
+        close(fd);
+        unlink(tmp.c_str());
+        return false;
+    }
+    close(fd);
+
+    if (rename(tmp.c_str(), path.c_str()) != 0) {
+        unlink(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+// Notification lives in record_schema.h: its on-disk layout is declared
+// there as a field list shared with the daemon.
 
 struct Task {
+    // Stable, monotonically assigned 64-bit ID. This is the key used for all
+    // cross-referencing; creation timestamps collide when two tasks are added
+    // in the same second, which corrupted edits in the old dates[0] scheme.
+    long long id = 0;
     std::string task;
     bool completed;
-    std::string category;
+    // Interned category: an index into categoryTable. There are typically a
+    // handful of distinct categories across tens of thousands of tasks, so
+    // storing a per-task heap string was pure waste — and every filter test
+    // was a string compare. 0 is the empty/uncategorized entry.
+    int categoryId = 0;
     // We'll store exactly two timestamps:
     //   dates[0] = creation time
     //   dates[1] = completion time (if completed)
     std::array<long long, 2> dates;
-    Notification notification; 
+    Notification notification;
+    // True for tasks paged in from the archive tier. Never serialized into
+    // todo.db; archived tasks live only in the archive file.
+    bool archived = false;
 };
 
-static std::vector<Notification> notifications;
+// Reminders keyed on the owning task's id, so reschedule/cancel and the
+// load-time join are O(1) lookups instead of scans comparing raw timestamps.
+// Entries from files that predate the key wait in unkeyedNotifications until
+// the task join adopts them; anything no live task claims is dropped there
+// rather than accumulating in notifications.db forever.
+static std::unordered_map<long long, Notification> notifications;
+static std::vector<Notification> unkeyedNotifications;
 static std::vector<Task> allTasks;
-static std::vector<Task> currentTasks;
-static std::vector<Task> completedTasks;
+
+// Virtualized views: allTasks is the only resident copy of the task records.
+// The current/completed "lists" are just vectors of indices into it, so
+// memory stays one Task per task regardless of history size, and rows are
+// only materialized (formatted) when they are actually painted.
+static std::vector<int> currentView;    // indices of uncompleted tasks, file order
+static std::vector<int> completedView;  // indices of completed tasks, file order
+
+static std::vector<int>& activeView();
 
 static int selectedIndex = 0;
 static int viewMode = 0;  // 0 = current, 1 = completed
 
+// Rows marked for a bulk operation (Space to toggle). Keyed on task id so
+// marks survive re-sorting and view switches.
+static std::unordered_set<long long> markedTaskIds;
+
+// ---------------------------------------------------------------------------
+// Interned category table.
+//
+// Each distinct category string is stored exactly once; tasks hold an index.
+// The table doubles as the incrementally-maintained unique-category list for
+// the filter overlay (no more rebuilding a std::set on every open), and the
+// strings themselves live contiguously for the lifetime of the process — the
+// table is the arena.
+// ---------------------------------------------------------------------------
+
+static std::vector<std::string> categoryTable = {""};
+static std::unordered_map<std::string, int> categoryIdByName = {{"", 0}};
+
+static int internCategory(const std::string& name) {
+    auto it = categoryIdByName.find(name);
+    if (it != categoryIdByName.end()) {
+        return it->second;
+    }
+    categoryTable.push_back(name);
+    int id = (int)categoryTable.size() - 1;
+    categoryIdByName[name] = id;
+    return id;
+}
+
+static const std::string& categoryName(int id) {
+    if (id < 0 || id >= (int)categoryTable.size()) {
+        return categoryTable[0];
+    }
+    return categoryTable[id];
+}
+
 // This category filter determines which items we display.
 // "All" means no filter; otherwise, show only tasks with matching category.
+// The id is what the hot filter loop compares; the string is for display.
 static std::string activeFilterCategory = "All";
+static int activeFilterCatId = -1;  // -1 = All
 
 static WINDOW* listWin = nullptr;
 
@@ -63,6 +197,7 @@ static void completeTask();
 static void deleteTask();
 static void gotoItem(int itemNum);
 static void setReminderOverlay();
+static bool cancelNotification(long long taskId);
 
 long long convertToSeconds(long long quantity, char unit) {
     switch (unit) {
@@ -81,6 +216,82 @@ long long get_unix_timestamp() {
     return timestamp;
 }
 
+// ---------------------------------------------------------------------------
+// Instrumentation.
+//
+// Scoped monotonic-clock timers around the event loop stages, feeding
+// fixed-size ring buffers (last 256 samples per stage, a few KB total).
+// 'p' toggles a one-line HUD with avg/p99 per stage; 'P' appends a full
+// percentile dump to perf.log in the data dir. clock_gettime(MONOTONIC)
+// is a vDSO call (~20ns), cheap enough to leave enabled in production —
+// which is the point: p99 keypress-to-paint latency from a real session,
+// not from a profiler run.
+// ---------------------------------------------------------------------------
+
+enum PerfStage { PERF_FRAME, PERF_DRAW, PERF_SORT, PERF_FILTER, PERF_STAGE_COUNT };
+static const char* const PERF_STAGE_NAMES[PERF_STAGE_COUNT] = {
+    "frame", "draw", "sort", "filter",
+};
+
+struct PerfRing {
+    static const int CAP = 256;
+    long long us[CAP];  // microseconds
+    int head = 0;
+    int count = 0;
+    void add(long long sample) {
+        us[head] = sample;
+        head = (head + 1) % CAP;
+        if (count < CAP) count++;
+    }
+};
+
+static PerfRing perfRings[PERF_STAGE_COUNT];
+static bool perfHudEnabled = false;
+
+static long long perfNowUs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+// RAII scope: construct at the top of a stage, sample lands on destruction.
+struct PerfScope {
+    PerfStage stage;
+    long long t0;
+    explicit PerfScope(PerfStage s) : stage(s), t0(perfNowUs()) {}
+    ~PerfScope() { perfRings[stage].add(perfNowUs() - t0); }
+};
+
+// pct in [0,100]; sorts a copy of the ring (256 entries, off the hot path).
+static long long perfPercentile(const PerfRing& r, int pct) {
+    if (r.count == 0) return 0;
+    std::vector<long long> sorted(r.us, r.us + r.count);
+    std::sort(sorted.begin(), sorted.end());
+    int idx = (int)((long long)pct * (r.count - 1) / 100);
+    return sorted[idx];
+}
+
+static long long perfAvg(const PerfRing& r) {
+    if (r.count == 0) return 0;
+    long long sum = 0;
+    for (int i = 0; i < r.count; i++) sum += r.us[i];
+    return sum / r.count;
+}
+
+// Append one timestamped block of per-stage percentiles to perf.log.
+static void perfDump() {
+    std::ofstream out(dataDir() + "/perf.log", std::ios::app);
+    if (!out.is_open()) return;
+    out << "# " << get_unix_timestamp() << "\n";
+    out << "stage,samples,avg_us,p50_us,p99_us,max_us\n";
+    for (int s = 0; s < PERF_STAGE_COUNT; s++) {
+        const PerfRing& r = perfRings[s];
+        out << PERF_STAGE_NAMES[s] << "," << r.count << ","
+            << perfAvg(r) << "," << perfPercentile(r, 50) << ","
+            << perfPercentile(r, 99) << "," << perfPercentile(r, 100) << "\n";
+    }
+}
+
 
 static std::string ncursesGetString(WINDOW* win, int startY, int startX, int maxLen = 1024, std::string result = "") {
     wchar_t ch;
@@ -137,360 +348,2130 @@ static std::string ncursesGetString(WINDOW* win, int startY, int startX, int max
     return result;
 }
 
-// Load notifications from NOTIFICATION_FILE
+// Load notifications from NOTIFICATION_FILE. The line layout (and its
+// tolerance for older generations with fewer fields) comes from the shared
+// schema in record_schema.h.
 void loadNotifications() {
-    std::vector<Notification> notifs;
+    std::unordered_map<long long, Notification> keyed;
+    std::vector<Notification> unkeyed;
+    int lock = acquireDataLock(LOCK_SH);
     std::ifstream inFile(NOTIFICATION_FILE);
 
     std::string line;
     while (std::getline(inFile, line)) {
         if (line.empty()) continue;
-        std::stringstream ss(line);
-        std::string part;
-
         Notification n;
-        // Format: <epoch_timestamp>;<triggered_flag>;<message>
-        if (std::getline(ss, part, ';')) {
-            n.scheduledTime = std::stoll(part);
-        }
-        if (std::getline(ss, part, ';')) {
-            n.triggered = (part == "1");
+        // Anything without at least the timestamp and triggered flag is a
+        // torn/garbled line; skip it and keep the rest of the file.
+        if (schema::parseTextRecord(line, n, schema::NOTIFICATION_FIELDS,
+                                    n.message) < 2) {
+            continue;
         }
-        if (std::getline(ss, part)) {
-            n.message = part;
+        if (n.scheduledTime == 0) continue;  // cancelled; nothing to keep
+        if (n.taskId != 0) {
+            keyed[n.taskId] = n;
+        } else {
+            unkeyed.push_back(n);
         }
-        notifs.push_back(n);
     }
     inFile.close();
-    notifications = notifs;
+    releaseDataLock(lock);
+    notifications = std::move(keyed);
+    unkeyedNotifications = std::move(unkeyed);
 }
 
-// Save notifications to NOTIFICATION_FILE
+// Save notifications to NOTIFICATION_FILE (temp file + rename; the daemon
+// writes this file too, so the swap has to be atomic and locked)
 void saveNotifications() {
-    std::ofstream outFile(NOTIFICATION_FILE, std::ios::trunc);
+    std::string out;
+    auto writeOne = [&out](const Notification& n) {
+        if (n.scheduledTime == 0) return;  // cancelled
+        schema::formatTextRecord(out, n, schema::NOTIFICATION_FIELDS,
+                                 n.message);
+        out += '\n';
+    };
+    for (auto &kv : notifications) writeOne(kv.second);
+    for (auto &n : unkeyedNotifications) writeOne(n);
+    int lock = acquireDataLock(LOCK_EX);
+    atomicWriteFile(NOTIFICATION_FILE, out);
+    releaseDataLock(lock);
+}
 
-    for (auto &n : notifications) {
-        outFile << n.scheduledTime << ";"
-                << (n.triggered ? "1" : "0") << ";"
-                << n.message << "\n";
+// ---------------------------------------------------------------------------
+// Binary on-disk format for TODO_FILE.
+//
+// The old format was one semicolon-separated text line per task, which meant
+// a stringstream + stoll chain per task at startup. With tens of thousands of
+// archived tasks that parse dominates launch time, so the DB is now a
+// versioned binary blob we can mmap() and walk with plain memcpy:
+//
+//   header:  magic 'TODO' (u32) | version (u32) | taskCount (u64)
+//   record:  id (i64, v2+)
+//            | dates[0] (i64) | dates[1] (i64) | notification time (i64)
+//            | completed (u8)
+//            | taskLen (u32) | task bytes | catLen (u32) | category bytes
+//
+// All integers are little-endian host order (this is a Linux-only tool).
+// Strings are length-prefixed, not NUL-terminated, so no scanning is needed.
+// A DB that doesn't start with the magic is assumed to be the legacy text
+// format; it is parsed once the old way and rewritten in binary on save.
+// ---------------------------------------------------------------------------
+
+static const uint32_t TODO_DB_MAGIC   = 0x4F444F54; // 'TODO'
+static const uint32_t TODO_DB_VERSION = 3; // v2 added the stable task id,
+                                           // v3 length-prefixed + CRC records
+
+// The record payload's raw block as a schema: one field list walked by both
+// the writer (appendFramedTask) and the reader (parseTaskFields), so the two
+// can never disagree on field order or width again. The strings (task text,
+// category) follow it, length-prefixed.
+static constexpr auto TASK_RECORD_FIELDS = std::make_tuple(
+    [](auto& t) -> auto& { return t.id; },
+    [](auto& t) -> auto& { return t.dates[0]; },
+    [](auto& t) -> auto& { return t.dates[1]; },
+    [](auto& t) -> auto& { return t.notification.scheduledTime; },
+    [](auto& t) -> auto& { return t.completed; });
+
+// Plain table-driven CRC32 (IEEE). One record is a few dozen bytes; this is
+// nowhere near the profile.
+static uint32_t crc32Buf(const void* data, size_t n) {
+    static uint32_t table[256];
+    static bool tableInit = false;
+    if (!tableInit) {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            table[i] = c;
+        }
+        tableInit = true;
     }
-    outFile.close();
+    uint32_t crc = 0xFFFFFFFFu;
+    const uint8_t* p = (const uint8_t*)data;
+    for (size_t i = 0; i < n; i++) {
+        crc = table[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
 }
 
-// Load tasks from TODO_FILE
-std::vector<Task> loadTasksFromFile() {
-    std::vector<Task> result;
-    std::ifstream inFile(TODO_FILE);
-    if (!inFile.is_open()) {
-        return result; // empty if no file
-    }
+// memcpy-based reads so we never do unaligned loads from the mapping.
+static bool readRaw(const char*& p, const char* end, void* out, size_t n) {
+    if ((size_t)(end - p) < n) return false;
+    std::memcpy(out, p, n);
+    p += n;
+    return true;
+}
 
-    std::string line;
-    while (std::getline(inFile, line)) {
-        if (line.empty()) continue;
-        std::stringstream ss(line);
-        std::string part;
+static bool readString(const char*& p, const char* end, std::string& out) {
+    uint32_t len = 0;
+    if (!readRaw(p, end, &len, sizeof(len))) return false;
+    if ((size_t)(end - p) < len) return false;
+    out.assign(p, len);
+    p += len;
+    return true;
+}
 
-        Task t;
-        // We assume the format is:
-        // dates[0];dates[1];completed;task;category;notification.scheduledTime
-        // all separated by semicolons, on one line per task.
+static void appendRaw(std::string& buf, const void* src, size_t n) {
+    buf.append(reinterpret_cast<const char*>(src), n);
+}
 
-        if (std::getline(ss, part, ';')) {
-            t.dates[0] = std::stoll(part);
-        }
-        if (std::getline(ss, part, ';')) {
-            t.dates[1] = std::stoll(part);
-        }
-        if (std::getline(ss, part, ';')) {
-            t.completed = (part == "1");
-        }
-        if (std::getline(ss, part, ';')) {
-            t.task = part;
-        }
-        if (std::getline(ss, part, ';')) {
-            t.category = part;
-        }
-        if (std::getline(ss, part, ';')) {
-            t.notification.scheduledTime = std::stoll(part);
-        }
-        // We'll look up the matching Notification in the global notifications vector
-        // if it exists:
-        for (size_t i = 0; i < notifications.size(); i++) {
-            if (t.notification.scheduledTime == notifications[i].scheduledTime) {
-                t.notification = notifications[i];
-                break;
-            }
-        }
-        result.push_back(t);
-    }
-    inFile.close();
-    return result;
+static void appendString(std::string& buf, const std::string& s) {
+    uint32_t len = (uint32_t)s.size();
+    appendRaw(buf, &len, sizeof(len));
+    buf.append(s);
 }
 
-// Save tasks to TODO_FILE (one line per task)
-void saveTasks() {
-    std::ofstream outFile(TODO_FILE, std::ios::trunc);
-    if (!outFile.is_open()) {
-        return;
-    }
-    for (auto &t : allTasks) {
-        outFile << t.dates[0] << ";"
-                << t.dates[1] << ";"
-                << (t.completed ? "1" : "0") << ";"
-                << t.task << ";"
-                << t.category << ";"
-                << t.notification.scheduledTime << "\n";
+// Parse one legacy text line in place with from_chars — no stringstream, no
+// per-field string copies. Legacy format:
+// dates[0];dates[1];completed;task;category;notification.scheduledTime
+// Trailing fields may be missing (mirrors the old getline chain); a
+// malformed numeric field skips the line. The category comes back as a raw
+// string because interning touches shared tables and this runs off-thread.
+static bool parseLegacyLine(const char* p, const char* end, Task& t,
+                            std::string& category) {
+    auto nextSep = [end](const char* s) {
+        const char* c = (const char*)memchr(s, ';', end - s);
+        return c ? c : end;
+    };
+
+    const char* f = nextSep(p);
+    if (std::from_chars(p, f, t.dates[0]).ec != std::errc()) return false;
+    if (f == end) return true;
+    p = f + 1;
+
+    f = nextSep(p);
+    if (std::from_chars(p, f, t.dates[1]).ec != std::errc()) return false;
+    if (f == end) return true;
+    p = f + 1;
+
+    f = nextSep(p);
+    t.completed = (f - p == 1 && *p == '1');
+    if (f == end) return true;
+    p = f + 1;
+
+    f = nextSep(p);
+    t.task.assign(p, f - p);
+    if (f == end) return true;
+    p = f + 1;
+
+    f = nextSep(p);
+    category.assign(p, f - p);
+    if (f == end) return true;
+    p = f + 1;
+
+    f = nextSep(p);
+    if (std::from_chars(p, f, t.notification.scheduledTime).ec != std::errc()) {
+        return false;
     }
-    outFile.close();
+    return true;
 }
 
-// Helper to draw text in a wrapped manner inside a curses window.
-static int drawWrappedText(WINDOW* win, int startY, int startX, int width, const std::string& text) {
-    if (text.empty()) {
-        mvwprintw(win, startY, startX, "%s", "");
-        return 1;
+// Per-thread parse output; spliced in file order after the join. The two
+// vectors are the thread's private arena — no shared state is touched until
+// the sequential intern pass at the end.
+struct LegacyChunk {
+    std::vector<Task> tasks;
+    std::vector<std::string> cats;
+};
+
+static void parseLegacyRange(const char* p, const char* end, LegacyChunk& out) {
+    while (p < end) {
+        const char* nl = (const char*)memchr(p, '\n', end - p);
+        const char* lineEnd = nl ? nl : end;
+        if (lineEnd > p) {
+            Task t;
+            std::string cat;
+            if (parseLegacyLine(p, lineEnd, t, cat)) {
+                out.tasks.push_back(std::move(t));
+                out.cats.push_back(std::move(cat));
+            }
+        }
+        p = nl ? nl + 1 : end;
     }
+}
 
-    int lineCount = 0;
-    int len = (int)text.size();
-    int pos = 0;
+// Parse the legacy semicolon-separated text format. Kept only as the one-time
+// migration path; new DBs are always written in binary. Large files are split
+// into newline-aligned chunks parsed in parallel — the format is line-
+// oriented, so any byte offset snaps forward to the next newline and chunks
+// never see partial records.
+static std::vector<Task> loadTasksLegacy(const char* data, size_t size) {
+    size_t nThreads = std::thread::hardware_concurrency();
+    if (nThreads > 16) nThreads = 16;
+    if (nThreads < 1) nThreads = 1;
+    if (size < (1u << 20)) nThreads = 1; // not worth the spawns below ~1MB
+
+    // Newline-aligned chunk boundaries
+    std::vector<const char*> bounds;
+    bounds.push_back(data);
+    for (size_t i = 1; i < nThreads; i++) {
+        const char* guess = data + (size * i) / nThreads;
+        const char* nl = (const char*)memchr(guess, '\n', (data + size) - guess);
+        const char* aligned = nl ? nl + 1 : data + size;
+        if (aligned > bounds.back()) bounds.push_back(aligned);
+    }
+    bounds.push_back(data + size);
 
-    while (pos < len) {
-        int end = pos + width;
-        if (end > len) end = len;
+    std::vector<LegacyChunk> chunks(bounds.size() - 1);
+    std::vector<std::thread> pool;
+    for (size_t i = 1; i < chunks.size(); i++) {
+        pool.emplace_back(parseLegacyRange, bounds[i], bounds[i + 1],
+                          std::ref(chunks[i]));
+    }
+    parseLegacyRange(bounds[0], bounds[1], chunks[0]); // this thread takes one
+    for (auto &th : pool) th.join();
 
-        // Try not to break words
-        if (end < len) {
-            int tmp = end;
-            while (tmp > pos && !std::isspace(static_cast<unsigned char>(text[tmp]))) {
-                tmp--;
-            }
-            if (tmp == pos) {
-                // can't break earlier, just break at 'end'
-                end = pos + width;
-            } else {
-                end = tmp;
-            }
+    // Splice in file order; interning is sequential and therefore safe.
+    size_t total = 0;
+    for (auto &c : chunks) total += c.tasks.size();
+    std::vector<Task> result;
+    result.reserve(total);
+    for (auto &c : chunks) {
+        for (size_t i = 0; i < c.tasks.size(); i++) {
+            c.tasks[i].categoryId = internCategory(c.cats[i]);
+            result.push_back(std::move(c.tasks[i]));
         }
+    }
+    return result;
+}
 
-        int substrLen = end - pos;
-        if (substrLen > width) {
-            substrLen = width;
+// Parse one record's fields (the payload inside the v3 length/CRC frame;
+// the whole record for v1/v2).
+static bool parseTaskFields(const char*& p, const char* end, uint32_t version,
+                            Task& t) {
+    if (version >= 2) {
+        if (!schema::parseRecordFields(p, end, t, TASK_RECORD_FIELDS)) {
+            return false;
         }
-        std::string buffer = text.substr(pos, substrLen);
-        mvwprintw(win, startY + lineCount, startX, "%s", buffer.c_str());
+    } else {
+        // v1 records had no id (those tasks get one assigned after loading);
+        // otherwise the raw block matches the schema minus its first field.
+        uint8_t completed = 0;
+        if (!readRaw(p, end, &t.dates[0], sizeof(long long))) return false;
+        if (!readRaw(p, end, &t.dates[1], sizeof(long long))) return false;
+        if (!readRaw(p, end, &t.notification.scheduledTime, sizeof(long long))) return false;
+        if (!readRaw(p, end, &completed, sizeof(completed))) return false;
+        t.completed = (completed != 0);
+    }
+    if (!readString(p, end, t.task)) return false;
+    std::string category;
+    if (!readString(p, end, category)) return false;
+    t.categoryId = internCategory(category);
+    return true;
+}
 
-        // move to the next segment
-        pos = end;
-        while (pos < len && std::isspace(static_cast<unsigned char>(text[pos]))) {
-            pos++;
+// Parse the binary format described above. Returns false if the blob is
+// truncated or the version is unknown; callers fall back to an empty list.
+// v3 records are individually framed and checksummed, so a torn or
+// corrupted record is skipped and the rest of the DB still loads.
+static bool loadTasksBinary(const char* data, size_t size, std::vector<Task>& result) {
+    const char* p = data;
+    const char* end = data + size;
+
+    uint32_t magic = 0, version = 0;
+    uint64_t count = 0;
+    if (!readRaw(p, end, &magic, sizeof(magic))) return false;
+    if (!readRaw(p, end, &version, sizeof(version))) return false;
+    if (!readRaw(p, end, &count, sizeof(count))) return false;
+    if (magic != TODO_DB_MAGIC || version < 1 || version > TODO_DB_VERSION) return false;
+
+    result.reserve(count);
+    for (uint64_t i = 0; i < count; i++) {
+        Task t;
+        if (version >= 3) {
+            uint32_t recLen = 0, crcStored = 0;
+            if (!readRaw(p, end, &recLen, sizeof(recLen))) break; // torn tail
+            if ((size_t)(end - p) < (size_t)recLen + sizeof(crcStored)) break;
+            const char* rec = p;
+            p += recLen;
+            readRaw(p, end, &crcStored, sizeof(crcStored));
+            if (crc32Buf(rec, recLen) != crcStored) {
+                continue; // skip the damaged record, keep the rest
+            }
+            const char* recEnd = rec + recLen;
+            if (!parseTaskFields(rec, recEnd, version, t)) continue;
+        } else {
+            // Pre-CRC formats have no framing: any parse failure means we
+            // can't find the next record either.
+            if (!parseTaskFields(p, end, version, t)) return false;
         }
-        lineCount++;
+        result.push_back(std::move(t));
     }
-
-    return (lineCount > 0) ? lineCount : 1;
+    return true;
 }
 
-// Safely format date/time info for a Task in two columns:
-//   - notification time
-//   - creation/completion time
-// Return a 2-element vector of strings: [reminder_time, relevant_date]
-std::vector<std::string> formatDate(const Task &task) {
-    std::vector<std::string> tuple(2);
-
-    // If the user has scheduled a reminder in the future
-    // (or it might be in the past), let's show that time:
-    long long st = task.notification.scheduledTime;
-
-    // We'll pick `task.dates[0]` if not completed, else `task.dates[1]`.
-    long long date = (task.completed ? task.dates[1] : task.dates[0]);
-
-    std::time_t tReminder = (std::time_t)st;
-    std::time_t tDate     = (std::time_t)date;
-
-    char bufReminder[64];
-    char bufDate[64];
+// Next id to hand out; kept one past the largest id seen on disk.
+static long long nextTaskId = 1;
 
-    // If st == 0, might mean "no reminder set"
-    if (st == 0) {
-        snprintf(bufReminder, sizeof(bufReminder), " ");
-    } else {
-        std::strftime(bufReminder, sizeof(bufReminder), "%Y-%m-%d %H:%M", std::localtime(&tReminder));
+// Give ids to tasks that don't have one yet (legacy text DBs and v1 binary
+// DBs predate the id field) and advance nextTaskId past everything loaded.
+static void assignMissingTaskIds(std::vector<Task>& tasks) {
+    for (auto &t : tasks) {
+        if (t.id >= nextTaskId) {
+            nextTaskId = t.id + 1;
+        }
+    }
+    for (auto &t : tasks) {
+        if (t.id == 0) {
+            t.id = nextTaskId++;
+        }
     }
+}
 
-    // Format creation/completion date
-    std::strftime(bufDate, sizeof(bufDate), "%Y-%m-%d %H:%M", std::localtime(&tDate));
+// Hash index from task id to position in allTasks, so mutations don't scan.
+// Rebuilt lazily after structural changes (delete / reload).
+static std::unordered_map<long long, size_t> taskIndexById;
+static bool taskIndexDirty = true;
 
-    tuple[0] = bufReminder;
-    tuple[1] = bufDate;
-    return tuple;
+static void invalidateTaskIndex() {
+    taskIndexDirty = true;
 }
 
-// Filter out tasks into currentTasks or completedTasks
-void filterTasks(const std::vector<Task>& raw) {
-    currentTasks.clear();
-    completedTasks.clear();
-
-    for (size_t i = 0; i < raw.size(); i++) {
-        if (raw[i].completed) {
-            completedTasks.push_back(raw[i]);
-        } else {
-            currentTasks.push_back(raw[i]);
+// O(1) lookup of a task's position in allTasks by id; -1 if not found.
+static int findTaskIndexById(long long id) {
+    if (taskIndexDirty) {
+        taskIndexById.clear();
+        taskIndexById.reserve(allTasks.size());
+        for (size_t i = 0; i < allTasks.size(); i++) {
+            taskIndexById[allTasks[i].id] = i;
         }
+        taskIndexDirty = false;
     }
+    auto it = taskIndexById.find(id);
+    return (it == taskIndexById.end()) ? -1 : (int)it->second;
 }
 
-// Draw the list portion of the UI
-static void drawListUI() {
-    // Determine column names based on view mode
-    const char* colnames = (viewMode == 0) ? " Current Tasks " : " Completed Tasks ";
-    const char* colcat   = " Category ";
-    const char* coldates = (viewMode == 0) ? " Added on " : " Completed on ";
-    const char* reminder = " Reminder ";
-
-    werase(listWin);
-    box(listWin, 0, 0);
+static Task* findTaskById(long long id) {
+    int idx = findTaskIndexById(id);
+    return (idx < 0) ? nullptr : &allTasks[idx];
+}
 
-    // top line inside the box
-    mvwprintw(listWin, 0, 2, " # ");
-    mvwprintw(listWin, 0, 6, "%s", colnames);
+// Load tasks from TODO_FILE
+std::vector<Task> loadTasksFromFile() {
+    std::vector<Task> result;
 
-    int dateColumnPos     = getmaxx(listWin) - 18;
-    int reminderColPos    = getmaxx(listWin) - 56;
-    int categoryColumnPos = getmaxx(listWin) - 36;
+    int lock = acquireDataLock(LOCK_SH);
+    int fd = open(TODO_FILE.c_str(), O_RDONLY);
+    if (fd < 0) {
+        releaseDataLock(lock);
+        return result; // empty if no file
+    }
 
-    mvwprintw(listWin, 0, reminderColPos, "%s", reminder);
-    mvwprintw(listWin, 0, categoryColumnPos, "%s", colcat);
-    mvwprintw(listWin, 0, dateColumnPos, "%s", coldates);
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        releaseDataLock(lock);
+        return result;
+    }
+    size_t size = (size_t)st.st_size;
+
+    void* map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    // Writers replace the DB by rename and never modify the inode our
+    // mapping points at, so the lock can drop as soon as the map exists.
+    releaseDataLock(lock);
+    if (map == MAP_FAILED) {
+        return result;
+    }
+    const char* data = (const char*)map;
 
-    // We will refer to either currentTasks or completedTasks
-    const std::vector<Task> &temp = (viewMode == 0) ? currentTasks : completedTasks;
+    uint32_t magic = 0;
+    if (size >= sizeof(magic)) {
+        std::memcpy(&magic, data, sizeof(magic));
+    }
 
-    // Build list of tasks that match activeFilterCategory
-    std::vector<int> filteredIndices;
-    filteredIndices.reserve(temp.size());
-    for (int i = 0; i < (int)temp.size(); i++) {
-        if (activeFilterCategory == "All" || temp[i].category == activeFilterCategory) {
-            filteredIndices.push_back(i);
+    if (magic == TODO_DB_MAGIC) {
+        if (!loadTasksBinary(data, size, result)) {
+            result.clear();
         }
+    } else {
+        // Legacy text DB: parse it once; the next saveTasks() migrates it.
+        result = loadTasksLegacy(data, size);
     }
-    // Clamp selectedIndex
-    if (!filteredIndices.empty()) {
-        if (selectedIndex >= (int)filteredIndices.size()) {
-            selectedIndex = (int)filteredIndices.size() - 1;
+    munmap(map, size);
+
+    assignMissingTaskIds(result);
+
+    // Attach reminders. Keyed entries are an O(1) id lookup; entries from a
+    // pre-key file fall back to the old scheduledTime match and get adopted
+    // under the task's id. Whatever is left afterwards belongs to no live
+    // task, so it is dropped here instead of accumulating in the file.
+    for (auto &t : result) {
+        auto it = notifications.find(t.id);
+        if (it != notifications.end()) {
+            t.notification = it->second;
+            continue;
         }
-        if (selectedIndex < 0) {
-            selectedIndex = 0;
+        for (auto uit = unkeyedNotifications.begin();
+             uit != unkeyedNotifications.end(); ++uit) {
+            if (t.notification.scheduledTime == uit->scheduledTime) {
+                t.notification = *uit;
+                t.notification.taskId = t.id;
+                notifications[t.id] = t.notification;
+                unkeyedNotifications.erase(uit);
+                break;
+            }
         }
-    } else {
-        selectedIndex = 0;
     }
+    unkeyedNotifications.clear();
+    return result;
+}
 
-    int taskCount = (int)filteredIndices.size();
-    int visibleLines = getmaxy(listWin) - 2;
-    int scrollOffset = 0;
-    if (selectedIndex >= visibleLines) {
-        scrollOffset = selectedIndex - (visibleLines - 1);
+// Serialize one task as a framed v3 record (len | payload | crc32).
+static void appendFramedTask(std::string& buf, const Task& t) {
+    std::string rec;
+    schema::appendRecordFields(rec, t, TASK_RECORD_FIELDS);
+    appendString(rec, t.task);
+    appendString(rec, categoryName(t.categoryId));
+
+    uint32_t recLen = (uint32_t)rec.size();
+    uint32_t crc = crc32Buf(rec.data(), rec.size());
+    appendRaw(buf, &recLen, sizeof(recLen));
+    buf.append(rec);
+    appendRaw(buf, &crc, sizeof(crc));
+}
+
+// Save tasks to TODO_FILE in the binary format (one record per task).
+// Archived tasks are excluded: they belong to the archive file. Returns
+// false when the snapshot did not durably reach the disk.
+bool saveTasks() {
+    uint64_t count = 0;
+    for (auto &t : allTasks) {
+        if (!t.archived) count++;
     }
 
-    int currentY = 1;
-    for (int idx = scrollOffset; idx < taskCount; idx++) {
-        if (currentY >= getmaxy(listWin) - 1) {
-            break;
-        }
-        int realIndex = filteredIndices[idx];
-        if (idx == selectedIndex) {
-            wattron(listWin, COLOR_PAIR(2));
-        } else {
-            wattron(listWin, COLOR_PAIR(3));
-        }
+    std::string buf;
+    buf.reserve(sizeof(uint32_t) * 2 + sizeof(uint64_t) + count * 64);
 
-        // Show the item number (1-based)
-        mvwprintw(listWin, currentY, 2, "%-3d", realIndex + 1);
+    appendRaw(buf, &TODO_DB_MAGIC, sizeof(TODO_DB_MAGIC));
+    appendRaw(buf, &TODO_DB_VERSION, sizeof(TODO_DB_VERSION));
+    appendRaw(buf, &count, sizeof(count));
 
-        // Show the category
-        mvwprintw(listWin, currentY, categoryColumnPos, "%-12s", temp[realIndex].category.c_str());
+    for (auto &t : allTasks) {
+        if (!t.archived) appendFramedTask(buf, t);
+    }
 
-        // Format the date/time strings
-        auto datesStr = formatDate(temp[realIndex]);
-        std::string reminderDate = datesStr[0];
-        std::string mainDate     = datesStr[1];
+    int lock = acquireDataLock(LOCK_EX);
+    bool ok = atomicWriteFile(TODO_FILE, buf);
+    releaseDataLock(lock);
+    return ok;
+}
 
-        mvwprintw(listWin, currentY, dateColumnPos, "%s", mainDate.c_str());
-        mvwprintw(listWin, currentY, reminderColPos, "%s", reminderDate.c_str());
+// ---------------------------------------------------------------------------
+// Archive tier.
+//
+// Completed tasks older than TODO_ARCHIVE_DAYS (default 90, 0 disables)
+// are moved on exit into todo.archive — a headerless run of the same framed
+// v3 records — which is NOT read at startup. Load time and resident memory
+// therefore scale with the active set, not with years of history. The first
+// Tab into the completed view pages the archive in; archived rows are then
+// ordinary tasks flagged `archived`, shown in the completed view but kept
+// out of todo.db by saveTasks(). If any of them is mutated (or newly
+// eligible rows are swept while the archive is resident) the whole archive
+// is rewritten on exit; otherwise the sweep is a pure append.
+// ---------------------------------------------------------------------------
+
+static const std::string ARCHIVE_FILE = dataDir() + "/todo.archive";
+
+static bool archiveLoaded = false;
+static bool archiveDirty = false;
+
+static void indexTaskText(long long id, const std::string& text);
+void rebuildViews();
+
+#ifndef TODO_BENCH  // only the exit-time sweep consults the age cutoff
+static int archiveAgeDays() {
+    const char* env = std::getenv("TODO_ARCHIVE_DAYS");
+    if (!env) return 90;
+    int days = atoi(env);
+    return (days < 0) ? 0 : days;
+}
+#endif // TODO_BENCH
 
-        // The task text (wrapped)
-        int linesUsed = drawWrappedText(listWin, currentY, 6,
-                                        reminderColPos - 7,
-                                        temp[realIndex].task);
+// Read every intact record out of the archive (same tolerant frame walk as
+// the v3 DB loader).
+static std::vector<Task> loadArchiveTasks() {
+    std::vector<Task> result;
 
-        if (idx == selectedIndex) {
-            wattroff(listWin, COLOR_PAIR(2));
-        } else {
-            wattroff(listWin, COLOR_PAIR(3));
-        }
-        currentY += linesUsed;
+    int fd = open(ARCHIVE_FILE.c_str(), O_RDONLY);
+    if (fd < 0) return result;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return result;
     }
+    size_t size = (size_t)st.st_size;
+    void* map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return result;
+
+    const char* p = (const char*)map;
+    const char* end = p + size;
+    while (p < end) {
+        uint32_t recLen = 0, crcStored = 0;
+        if (!readRaw(p, end, &recLen, sizeof(recLen))) break;
+        if ((size_t)(end - p) < (size_t)recLen + sizeof(crcStored)) break;
+        const char* rec = p;
+        p += recLen;
+        readRaw(p, end, &crcStored, sizeof(crcStored));
+        if (crc32Buf(rec, recLen) != crcStored) continue;
 
-    wnoutrefresh(stdscr);
-    wnoutrefresh(listWin);
+        Task t;
+        const char* recEnd = rec + recLen;
+        if (!parseTaskFields(rec, recEnd, TODO_DB_VERSION, t)) continue;
+        t.archived = true;
+        result.push_back(std::move(t));
+    }
+    munmap(map, size);
+    return result;
 }
 
-static void drawUI() {
-    // Draw header on stdscr
-    wattron(stdscr, COLOR_PAIR(3));
-    mvprintw(1, 2, "CLI TODO APP");
-    mvprintw(2, 2, "Current Tasks: %zu | Completed Tasks: %zu",
-             currentTasks.size(), completedTasks.size());
-    mvhline(3, 2, ACS_HLINE, COLS - 4);
-    mvprintw(4, 2, "Keys: c=complete, d=delete, n=add, s=category, r=reminder, e=edit, #:filter, Tab=switch, q=save+exit");
-    mvprintw(5, 2, "Nav: Up/Down, PgUp/PgDn, Home/End, Goto ':<num>'");
-    mvprintw(6, 2, "Category Filter: %s                 ", activeFilterCategory.c_str() );
-    wattroff(stdscr, COLOR_PAIR(3));
+// Page the archive into allTasks the first time the completed view needs it.
+static void ensureArchiveLoaded() {
+    if (archiveLoaded) return;
+    archiveLoaded = true;
 
-    drawListUI();
-}
-
-// Overlay to add a new task
-static void addTaskOverlay() {
-    int overlayHeight = 7;
-    int overlayWidth = COLS - 20;
-    int overlayY = (LINES - overlayHeight) / 2;
-    int overlayX = (COLS - overlayWidth) / 2;
+    std::vector<Task> archived = loadArchiveTasks();
+    if (archived.empty()) return;
 
-    WINDOW* overlayWin = newwin(overlayHeight, overlayWidth, overlayY, overlayX);
-    wbkgd(overlayWin, COLOR_PAIR(3));
-    box(overlayWin, 0, 0);
-    mvwprintw(overlayWin, 1, 2, "Enter new task:");
-    wrefresh(overlayWin);
+    for (auto &t : archived) {
+        indexTaskText(t.id, t.task);
+        allTasks.push_back(std::move(t));
+    }
+    invalidateTaskIndex();
+    rebuildViews();
+}
 
-    Task new_task;
-    new_task.task = ncursesGetString(overlayWin, 2, 2, 1024);
+// A mutation touched an archived task; the append-only sweep is no longer
+// enough and the archive must be rewritten on exit.
+static void touchArchived(const Task& t) {
+    if (t.archived) archiveDirty = true;
+}
 
-    if (!new_task.task.empty()) {
-        // Set creation time
-        new_task.dates[0] = get_unix_timestamp();
-        new_task.dates[1] = 0; // not completed yet
-        new_task.completed = false;
-        // Insert it into the master list
-        allTasks.push_back(new_task);
-        // Also into current tasks
-        currentTasks.push_back(new_task);
-        // The newly added task is at index = currentTasks.size()-1
-        int idx = (int)currentTasks.size() - 1;
-        // (because addCategoryOverlay changes currentTasks[idx].category)
-        allTasks.back().category = currentTasks[idx].category;
+// Exit-time sweep: move old completed tasks into the archive and drop them
+// from the active set (before journalCompact snapshots it).
+#ifndef TODO_BENCH  // exit path; bench tears its screen down without quitting
+static void archiveSweep() {
+    int days = archiveAgeDays();
+    long long cutoff = (days > 0)
+        ? get_unix_timestamp() - (long long)days * 86400LL
+        : 0;
+
+    if (cutoff > 0) {
+        for (auto &t : allTasks) {
+            if (!t.archived && t.completed && t.dates[1] != 0 &&
+                t.dates[1] < cutoff) {
+                t.archived = true;
+                if (archiveLoaded) {
+                    archiveDirty = true; // the rewrite below persists it
+                } else {
+                    // Archive not resident: persist by pure append
+                    std::string buf;
+                    appendFramedTask(buf, t);
+                    int fd = open(ARCHIVE_FILE.c_str(),
+                                  O_WRONLY | O_APPEND | O_CREAT, 0664);
+                    if (fd >= 0) {
+                        ssize_t n = write(fd, buf.data(), buf.size());
+                        (void)n;
+                        close(fd);
+                    }
+                }
+            }
+        }
+    }
 
+    if (archiveDirty) {
+        std::string buf;
+        for (auto &t : allTasks) {
+            if (t.archived) appendFramedTask(buf, t);
+        }
+        int lock = acquireDataLock(LOCK_EX);
+        atomicWriteFile(ARCHIVE_FILE, buf);
+        releaseDataLock(lock);
+        archiveDirty = false;
     }
-    delwin(overlayWin);
+}
+#endif // TODO_BENCH
+
+// ---------------------------------------------------------------------------
+// Append-only mutation journal.
+//
+// Rewriting the whole DB on every exit means a single completed task costs a
+// multi-megabyte write once the history grows, and a crash mid-truncate can
+// lose everything. Instead each mutation appends one small record to
+// JOURNAL_FILE and fsyncs it, so a keypress costs one sequential append. The
+// binary DB is only rewritten ("compacted") when the journal is folded back
+// in: at startup after replay, and on save+exit.
+//
+// Record format, one text line per mutation, keyed on the stable task id:
+//   A;<id>;<dates0>;<category>;<task>  add (task text last, may hold ';')
+//   C;<id>;<dates1>                    complete
+//   E;<id>;<task>                      edit text
+//   D;<id>                             delete
+//   G;<id>;<category>                  set category
+//   R;<id>;<scheduledTime>             set reminder
+// ---------------------------------------------------------------------------
+
+static int journalFd = -1;
+
+// Write one record and fsync so the mutation survives a crash. Runs on the
+// persistence thread, never on the UI thread.
+static void journalWrite(const std::string& record) {
+    if (journalFd < 0) {
+        journalFd = open(JOURNAL_FILE.c_str(), O_WRONLY | O_APPEND | O_CREAT, 0664);
+        if (journalFd < 0) return;
+    }
+    std::string line = record + "\n";
+    ssize_t n = write(journalFd, line.data(), line.size());
+    (void)n;
+    fsync(journalFd);
 }
 
-
-// Overlay to add a new task
-std::string editTaskOverlay(Task task) {
-    int overlayHeight = 7;
-    int overlayWidth = COLS - 20;
+// ---------------------------------------------------------------------------
+// Background persistence thread.
+//
+// The fsync per mutation is exactly what we want for durability, but not on
+// the UI thread: a slow disk turns a keypress into a visible stall. Handlers
+// therefore just enqueue the record under a mutex (the queue holds a few
+// short strings; contention is nil) and the writer thread drains it, writing
+// a whole batch and fsyncing once per drain. journalFlush() provides the
+// barrier the exit path needs before compacting.
+// ---------------------------------------------------------------------------
+
+static std::deque<std::string> journalQueue;
+static std::mutex journalMutex;
+static std::condition_variable journalCv;       // signals the writer
+static std::condition_variable journalDrainedCv; // signals flush waiters
+static std::thread journalThread;
+static bool journalThreadRunning = false;
+static bool journalShutdown = false;
+static size_t journalPending = 0;  // queued or being written right now
+// Records appended since the last compaction; only the UI thread touches it,
+// so no lock. Drives idle-time compaction in the event loop.
+static long long journalRecordsSinceCompact = 0;
+
+static void journalWriterLoop() {
+    while (true) {
+        std::deque<std::string> batch;
+        {
+            std::unique_lock<std::mutex> lock(journalMutex);
+            journalCv.wait(lock, [] {
+                return !journalQueue.empty() || journalShutdown;
+            });
+            if (journalQueue.empty() && journalShutdown) {
+                return;
+            }
+            batch.swap(journalQueue);
+        }
+        for (auto &record : batch) {
+            journalWrite(record);
+        }
+        {
+            std::lock_guard<std::mutex> lock(journalMutex);
+            journalPending -= batch.size();
+        }
+        journalDrainedCv.notify_all();
+    }
+}
+
+static void syncLogAppend(const std::string& record);
+
+// Queue one mutation record for the writer thread. Before the thread exists
+// (startup replay, headless paths) the record is written synchronously.
+// Every locally-originated mutation also lands in the sync log, which is
+// what other devices pull from.
+static void journalAppend(const std::string& record) {
+    syncLogAppend(record);
+    journalRecordsSinceCompact++;
+    {
+        std::lock_guard<std::mutex> lock(journalMutex);
+        if (!journalThreadRunning) {
+            journalWrite(record);
+            return;
+        }
+        journalQueue.push_back(record);
+        journalPending++;
+    }
+    journalCv.notify_one();
+}
+
+static void startJournalThread() {
+    journalShutdown = false;
+    journalThread = std::thread(journalWriterLoop);
+    {
+        std::lock_guard<std::mutex> lock(journalMutex);
+        journalThreadRunning = true;
+    }
+}
+
+// Block until every queued record has hit the disk.
+#ifndef TODO_BENCH  // compaction-only; bench stops the thread, which drains
+static void journalFlush() {
+    std::unique_lock<std::mutex> lock(journalMutex);
+    if (!journalThreadRunning) return;
+    journalDrainedCv.wait(lock, [] { return journalPending == 0; });
+}
+#endif // TODO_BENCH
+
+static void stopJournalThread() {
+    {
+        std::lock_guard<std::mutex> lock(journalMutex);
+        if (!journalThreadRunning) return;
+        journalShutdown = true;
+        journalThreadRunning = false;
+    }
+    journalCv.notify_one();
+    journalThread.join();
+}
+
+// Replay and compaction belong to the load and exit paths; bench builds its
+// task set in memory and only ever appends.
+#ifndef TODO_BENCH
+
+// Apply one journal record to a task list. Unknown or malformed records are
+// skipped so a torn final line can't poison the replay.
+static void applyJournalRecord(std::vector<Task>& tasks, const std::string& line) {
+    if (line.size() < 2 || line[1] != ';') return;
+    char op = line[0];
+
+    // Split off the key (the task id) following the op code.
+    size_t keyEnd = line.find(';', 2);
+    std::string keyStr = (keyEnd == std::string::npos)
+                             ? line.substr(2)
+                             : line.substr(2, keyEnd - 2);
+    long long key = 0;
+    try {
+        key = std::stoll(keyStr);
+    } catch (...) {
+        return;
+    }
+    std::string rest = (keyEnd == std::string::npos) ? "" : line.substr(keyEnd + 1);
+
+    if (op == 'A') {
+        // rest = <dates0>;<category>;<task>
+        size_t sep1 = rest.find(';');
+        if (sep1 == std::string::npos) return;
+        size_t sep2 = rest.find(';', sep1 + 1);
+        if (sep2 == std::string::npos) return;
+        Task t;
+        t.id = key;
+        try {
+            t.dates[0] = std::stoll(rest.substr(0, sep1));
+        } catch (...) {
+            return;
+        }
+        t.dates[1] = 0;
+        t.completed = false;
+        t.categoryId = internCategory(rest.substr(sep1 + 1, sep2 - sep1 - 1));
+        t.task = rest.substr(sep2 + 1);
+        t.notification.scheduledTime = 0;
+        tasks.push_back(std::move(t));
+        return;
+    }
+
+    for (size_t i = 0; i < tasks.size(); i++) {
+        if (tasks[i].id != key) continue;
+        switch (op) {
+            case 'C':
+                try {
+                    tasks[i].dates[1] = std::stoll(rest);
+                } catch (...) {
+                    tasks[i].dates[1] = 0;
+                }
+                // timestamp 0 is an un-complete (written by undo)
+                tasks[i].completed = (tasks[i].dates[1] != 0);
+                break;
+            case 'E':
+                tasks[i].task = rest;
+                break;
+            case 'D':
+                tasks.erase(tasks.begin() + i);
+                break;
+            case 'G':
+                tasks[i].categoryId = internCategory(rest);
+                break;
+            case 'R':
+                // rest = <scheduledTime>[;<interval>;<weekdays>]
+                try {
+                    size_t sep1 = rest.find(';');
+                    tasks[i].notification.scheduledTime =
+                        std::stoll(rest.substr(0, sep1));
+                    if (sep1 != std::string::npos) {
+                        size_t sep2 = rest.find(';', sep1 + 1);
+                        if (sep2 != std::string::npos) {
+                            tasks[i].notification.repeatInterval =
+                                std::stoll(rest.substr(sep1 + 1, sep2 - sep1 - 1));
+                            tasks[i].notification.repeatWeekdays =
+                                std::stoi(rest.substr(sep2 + 1));
+                        }
+                    }
+                    tasks[i].notification.message = tasks[i].task;
+                } catch (...) {
+                }
+                break;
+            default:
+                break;
+        }
+        return;
+    }
+}
+
+// Replay the journal on top of the freshly loaded snapshot. Returns true if
+// any records were applied (i.e. the snapshot on disk is stale).
+static bool journalReplay(std::vector<Task>& tasks) {
+    std::ifstream in(JOURNAL_FILE);
+    if (!in.is_open()) return false;
+
+    bool applied = false;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty()) continue;
+        applyJournalRecord(tasks, line);
+        applied = true;
+    }
+    return applied;
+}
+
+// Fold the journal into the binary snapshot: rewrite the DB, then truncate
+// the journal. After this the journal is empty and the snapshot is current.
+static void journalCompact() {
+    journalFlush();  // everything queued must be on disk before we truncate
+    if (!saveTasks()) {
+        // Snapshot never landed (disk full and friends). The journal is the
+        // only copy of those mutations now — keep it and retry later.
+        return;
+    }
+    if (journalFd >= 0) {
+        close(journalFd);
+        journalFd = -1;
+    }
+    int fd = open(JOURNAL_FILE.c_str(), O_WRONLY | O_TRUNC | O_CREAT, 0664);
+    if (fd >= 0) close(fd);
+    journalRecordsSinceCompact = 0;
+}
+#endif // TODO_BENCH
+
+// ---------------------------------------------------------------------------
+// Multi-device sync.
+//
+// The sync log is a timestamped copy of every locally-originated journal
+// record (remote records applied during a sync are deliberately NOT logged,
+// or two devices would echo each other's mutations back and forth forever).
+// A sync session exchanges only the entries the peer hasn't seen — per-peer
+// cursors live in todo.syncstate — so a week of offline edits is kilobytes
+// on the wire, not the whole DB.
+//
+// Conflict rule: last-writer-wins per field, where the "field" is the
+// journal op (text/category/completion/reminder; add+delete share one
+// existence slot). A remote record only has to beat the local entries the
+// peer hasn't pulled yet — anything older is already on both sides — and
+// ties break on device id so both ends pick the same winner. A concurrent
+// delete beats an edit: the edit's record finds no task to apply to.
+//
+// Transports:
+//   todo sync <host>[:port]   one-shot client against sync-serve
+//   todo sync ssh:<host>      spawns `ssh <host> todo sync-stdio`
+//   todo sync-serve [port]    TCP peer, one session at a time
+//   todo sync-stdio           speaks the protocol on stdin/stdout
+//
+// Wire protocol (text lines; client speaks first at every step so neither
+// end can deadlock on a full pipe):
+//   both:    HELLO <deviceId> <seqOfPeerLogAlreadyApplied>
+//   client:  REC <seq> <ts> <record> ... END <lastSeq>
+//   server:  REC <seq> <ts> <record> ... END <lastSeq>
+// ---------------------------------------------------------------------------
+
+static const std::string SYNCLOG_FILE   = dataDir() + "/todo.synclog";
+static const std::string SYNCSTATE_FILE = dataDir() + "/todo.syncstate";
+static const int SYNC_DEFAULT_PORT = 5757;
+
+// Stable random identity for this install; created on first sync.
+#ifndef TODO_BENCH  // only sync sessions need an identity
+static long long syncDeviceId() {
+    static long long cached = 0;
+    if (cached) return cached;
+
+    std::ifstream in(dataDir() + "/todo.deviceid");
+    if (in.is_open() && (in >> cached) && cached > 0) return cached;
+
+    cached = ((long long)get_unix_timestamp() << 20) ^
+             ((long long)getpid() << 10) ^ (long long)random();
+    cached &= 0x7FFFFFFFFFFFLL;
+    if (cached == 0) cached = 1;
+    std::ofstream out(dataDir() + "/todo.deviceid", std::ios::trunc);
+    out << cached << "\n";
+    return cached;
+}
+#endif // TODO_BENCH
+
+// Task ids must never collide across devices or a sync would splice two
+// unrelated tasks together. Seconds-since-epoch in the high bits keeps ids
+// roughly creation-ordered; 20 random bits below make a same-second
+// collision between two devices a one-in-a-million event, and the probe
+// loop handles the local case.
+static long long allocateTaskId() {
+    static bool seeded = false;
+    if (!seeded) {
+        srandom((unsigned)(get_unix_timestamp() ^ getpid()));
+        seeded = true;
+    }
+    long long id = (get_unix_timestamp() << 20) | (random() & 0xFFFFF);
+    while (findTaskIndexById(id) >= 0) id++;
+    return id;
+}
+
+// One parsed sync-log entry. seq is its stable position in the log.
+struct SyncLogEntry {
+    long long seq;
+    long long ts;
+    std::string record;
+};
+
+// Append one local mutation with a wall-clock stamp. Plain buffered append,
+// no fsync: the journal is the durability story, the sync log only has to
+// be correct when a sync actually runs.
+static void syncLogAppend(const std::string& record) {
+    std::ofstream out(SYNCLOG_FILE, std::ios::app);
+    out << get_unix_timestamp() << "|" << record << "\n";
+}
+
+// The rest of the sync machinery runs only inside a session; bench appends
+// to the sync log (via journalAppend) but never syncs.
+#ifndef TODO_BENCH
+
+// Entries with seq > afterSeq, in log order. Also reports the last seq in
+// the log via lastSeq (equal to afterSeq when nothing is pending).
+static std::vector<SyncLogEntry> syncLogRead(long long afterSeq, long long& lastSeq) {
+    std::vector<SyncLogEntry> out;
+    lastSeq = 0;
+    std::ifstream in(SYNCLOG_FILE);
+    if (!in.is_open()) return out;
+
+    std::string line;
+    long long seq = 0;
+    while (std::getline(in, line)) {
+        if (line.empty()) continue;
+        seq++;
+        if (seq <= afterSeq) continue;
+        size_t bar = line.find('|');
+        if (bar == std::string::npos) continue;
+        SyncLogEntry e;
+        e.seq = seq;
+        try {
+            e.ts = std::stoll(line.substr(0, bar));
+        } catch (...) {
+            continue;
+        }
+        e.record = line.substr(bar + 1);
+        out.push_back(std::move(e));
+    }
+    lastSeq = seq;
+    return out;
+}
+
+// Per-peer cursor: how far into the peer's log we have applied.
+static long long syncStateGet(long long peerId) {
+    std::ifstream in(SYNCSTATE_FILE);
+    std::string line;
+    while (std::getline(in, line)) {
+        std::stringstream ss(line);
+        long long id = 0, seq = 0;
+        if ((ss >> id >> seq) && id == peerId) return seq;
+    }
+    return 0;
+}
+
+static void syncStateSet(long long peerId, long long seq) {
+    std::vector<std::pair<long long, long long>> entries;
+    {
+        std::ifstream in(SYNCSTATE_FILE);
+        std::string line;
+        while (std::getline(in, line)) {
+            std::stringstream ss(line);
+            long long id = 0, s = 0;
+            if ((ss >> id >> s) && id != peerId) entries.push_back({id, s});
+        }
+    }
+    entries.push_back({peerId, seq});
+    std::ostringstream out;
+    for (auto &e : entries) out << e.first << " " << e.second << "\n";
+    atomicWriteFile(SYNCSTATE_FILE, out.str());
+}
+
+// The LWW "field" a record writes to. Add and delete share the existence
+// slot; everything else conflicts only with itself.
+static char recordFieldTag(const std::string& record) {
+    char op = record.empty() ? '?' : record[0];
+    return (op == 'A' || op == 'D') ? 'X' : op;
+}
+
+static long long recordTaskId(const std::string& record) {
+    if (record.size() < 3 || record[1] != ';') return 0;
+    try {
+        return std::stoll(record.substr(2, record.find(';', 2) - 2));
+    } catch (...) {
+        return 0;
+    }
+}
+
+// Merge the peer's entries into allTasks. localPending is what we are about
+// to send them (the only local writes they can conflict with).
+static int syncApplyRemote(const std::vector<SyncLogEntry>& remote,
+                           const std::vector<SyncLogEntry>& localPending,
+                           long long remoteId) {
+    long long ourId = syncDeviceId();
+
+    // (taskId, field) -> newest local pending timestamp
+    std::map<std::pair<long long, char>, long long> localTs;
+    for (auto &e : localPending) {
+        auto key = std::make_pair(recordTaskId(e.record), recordFieldTag(e.record));
+        if (e.ts > localTs[key]) localTs[key] = e.ts;
+    }
+
+    int applied = 0;
+    for (auto &e : remote) {
+        auto key = std::make_pair(recordTaskId(e.record), recordFieldTag(e.record));
+        auto it = localTs.find(key);
+        if (it != localTs.end()) {
+            // Same field touched on both sides since the last sync: newer
+            // timestamp wins, device id breaks ties identically on both ends.
+            if (it->second > e.ts || (it->second == e.ts && ourId > remoteId)) {
+                continue;
+            }
+        }
+        // A re-add of a task we already have is an echo of shared history
+        if (e.record[0] == 'A' && findTaskIndexById(recordTaskId(e.record)) >= 0) {
+            continue;
+        }
+        applyJournalRecord(allTasks, e.record);
+        invalidateTaskIndex();
+        applied++;
+    }
+    return applied;
+}
+
+// One complete sync conversation over a pair of stdio streams. Both sides
+// run this; `initiator` decides who speaks first at each step.
+static int syncSession(FILE* in, FILE* out, bool initiator) {
+    long long ourId = syncDeviceId();
+    char line[8192];
+
+    // Load exactly the way the TUI does, so un-compacted local mutations
+    // are part of the picture before we merge.
+    loadNotifications();
+    allTasks = loadTasksFromFile();
+    if (journalReplay(allTasks)) {
+        assignMissingTaskIds(allTasks);
+        invalidateTaskIndex();
+    }
+
+    auto sendHello = [&]() {
+        // We don't know the peer's id on the initiating side yet; the
+        // cursor is re-sent once identities are established.
+        fprintf(out, "HELLO %lld\n", ourId);
+        fflush(out);
+    };
+    auto readHello = [&](long long& peerId) {
+        if (!fgets(line, sizeof(line), in)) return false;
+        return sscanf(line, "HELLO %lld", &peerId) == 1;
+    };
+    auto sendCursor = [&](long long peerId) {
+        fprintf(out, "HAVE %lld\n", syncStateGet(peerId));
+        fflush(out);
+    };
+    auto readCursor = [&](long long& seq) {
+        if (!fgets(line, sizeof(line), in)) return false;
+        return sscanf(line, "HAVE %lld", &seq) == 1;
+    };
+    auto sendEntries = [&](const std::vector<SyncLogEntry>& entries,
+                           long long lastSeq) {
+        for (auto &e : entries) {
+            fprintf(out, "REC %lld %lld %s\n", e.seq, e.ts, e.record.c_str());
+        }
+        fprintf(out, "END %lld\n", lastSeq);
+        fflush(out);
+    };
+    auto readEntries = [&](std::vector<SyncLogEntry>& entries, long long& lastSeq) {
+        while (fgets(line, sizeof(line), in)) {
+            size_t len = strlen(line);
+            if (len && line[len - 1] == '\n') line[len - 1] = '\0';
+            if (strncmp(line, "END ", 4) == 0) {
+                lastSeq = atoll(line + 4);
+                return true;
+            }
+            SyncLogEntry e;
+            int consumed = 0;
+            if (sscanf(line, "REC %lld %lld %n", &e.seq, &e.ts, &consumed) != 2) {
+                return false;
+            }
+            e.record = line + consumed;
+            entries.push_back(std::move(e));
+        }
+        return false;
+    };
+
+    long long peerId = 0;
+    if (initiator) {
+        sendHello();
+        if (!readHello(peerId)) return 1;
+        sendCursor(peerId);
+    } else {
+        if (!readHello(peerId)) return 1;
+        sendHello();
+    }
+
+    long long peerHasOfUs = 0, weHaveOfPeer = syncStateGet(peerId);
+    if (initiator) {
+        if (!readCursor(peerHasOfUs)) return 1;
+    } else {
+        if (!readCursor(peerHasOfUs)) return 1;
+        sendCursor(peerId);
+    }
+
+    long long ourLastSeq = 0;
+    std::vector<SyncLogEntry> outbound = syncLogRead(peerHasOfUs, ourLastSeq);
+    std::vector<SyncLogEntry> inbound;
+    long long peerLastSeq = weHaveOfPeer;
+
+    if (initiator) {
+        sendEntries(outbound, ourLastSeq);
+        if (!readEntries(inbound, peerLastSeq)) return 1;
+    } else {
+        if (!readEntries(inbound, peerLastSeq)) return 1;
+        sendEntries(outbound, ourLastSeq);
+    }
+
+    int applied = syncApplyRemote(inbound, outbound, peerId);
+    if (applied > 0 || !inbound.empty()) {
+        // Fold-and-truncate like TUI startup does. A bare saveTasks() here
+        // would bake replayed journal records into the snapshot while leaving
+        // them in the journal, so the next load applies each one twice (and a
+        // replayed A re-inserts its task under the same id).
+        journalCompact();
+    }
+    syncStateSet(peerId, peerLastSeq);
+
+    fprintf(stderr, "sync: sent %zu, received %zu, applied %d (peer %lld)\n",
+            outbound.size(), inbound.size(), applied, peerId);
+    return 0;
+}
+
+// `todo sync <host>[:port]` / `todo sync ssh:<host>`
+static int runSyncClient(const std::string& target) {
+    if (target.empty()) {
+        fprintf(stderr, "usage: todo sync <host>[:port] | todo sync ssh:<host>\n");
+        return 1;
+    }
+
+    if (target.rfind("ssh:", 0) == 0) {
+        // Tunnel the stdio protocol through ssh; the remote binary does the
+        // other half. No port to open, auth is ssh's problem.
+        std::string host = target.substr(4);
+        int toChild[2], fromChild[2];
+        if (pipe(toChild) != 0 || pipe(fromChild) != 0) return 1;
+        pid_t pid = fork();
+        if (pid < 0) return 1;
+        if (pid == 0) {
+            dup2(toChild[0], 0);
+            dup2(fromChild[1], 1);
+            close(toChild[0]); close(toChild[1]);
+            close(fromChild[0]); close(fromChild[1]);
+            execlp("ssh", "ssh", host.c_str(), "todo", "sync-stdio", (char*)nullptr);
+            _exit(127);
+        }
+        close(toChild[0]);
+        close(fromChild[1]);
+        FILE* out = fdopen(toChild[1], "w");
+        FILE* in = fdopen(fromChild[0], "r");
+        int rc = (in && out) ? syncSession(in, out, true) : 1;
+        if (out) fclose(out);
+        if (in) fclose(in);
+        int status = 0;
+        waitpid(pid, &status, 0);
+        return rc;
+    }
+
+    std::string host = target;
+    std::string port = std::to_string(SYNC_DEFAULT_PORT);
+    size_t colon = target.find(':');
+    if (colon != std::string::npos) {
+        host = target.substr(0, colon);
+        port = target.substr(colon + 1);
+    }
+
+    struct addrinfo hints, *res = nullptr;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(host.c_str(), port.c_str(), &hints, &res) != 0 || !res) {
+        fprintf(stderr, "sync: cannot resolve %s\n", host.c_str());
+        return 1;
+    }
+    int fd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+    if (fd < 0 || connect(fd, res->ai_addr, res->ai_addrlen) != 0) {
+        fprintf(stderr, "sync: cannot connect to %s:%s\n", host.c_str(), port.c_str());
+        freeaddrinfo(res);
+        if (fd >= 0) close(fd);
+        return 1;
+    }
+    freeaddrinfo(res);
+
+    FILE* in = fdopen(fd, "r");
+    FILE* out = fdopen(dup(fd), "w");
+    int rc = (in && out) ? syncSession(in, out, true) : 1;
+    if (out) fclose(out);
+    if (in) fclose(in);
+    return rc;
+}
+
+// `todo sync-serve [port]`: accept one session at a time, forever.
+static int runSyncServer(int port) {
+    int listenFd = socket(AF_INET, SOCK_STREAM, 0);
+    if (listenFd < 0) return 1;
+    int one = 1;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    struct sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons((uint16_t)port);
+    if (bind(listenFd, (struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+        listen(listenFd, 1) != 0) {
+        fprintf(stderr, "sync-serve: cannot listen on port %d\n", port);
+        close(listenFd);
+        return 1;
+    }
+    fprintf(stderr, "sync-serve: listening on port %d\n", port);
+
+    while (true) {
+        int fd = accept(listenFd, nullptr, nullptr);
+        if (fd < 0) continue;
+        FILE* in = fdopen(fd, "r");
+        FILE* out = fdopen(dup(fd), "w");
+        if (in && out) syncSession(in, out, false);
+        if (out) fclose(out);
+        if (in) fclose(in);
+    }
+    return 0;
+}
+#endif // TODO_BENCH
+
+// ---------------------------------------------------------------------------
+// Headless CLI.
+//
+// `todo add/done/list` run without curses so shell scripts and git hooks can
+// drive the task list. `add` is the hot one: it appends a single journal
+// record (plus its sync-log copy) and exits — no DB parse, no snapshot
+// rewrite — so a hook-invoked add is one fsync'd append regardless of how
+// large the DB is. The record is folded into todo.db the next time anything
+// replays the journal. `done` and `list` need the task set and load it the
+// same way the TUI does.
+// ---------------------------------------------------------------------------
+#ifndef TODO_BENCH
+
+// Pull --category=X out of an argv tail; remaining words are returned in
+// order (for `add`, they are the task text).
+static std::string cliExtractCategory(int argc, char** argv, int from,
+                                      std::vector<std::string>& words) {
+    std::string category;
+    for (int i = from; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.rfind("--category=", 0) == 0) {
+            category = arg.substr(11);
+        } else {
+            words.push_back(arg);
+        }
+    }
+    return category;
+}
+
+static void cliLoadTasks() {
+    loadNotifications();
+    allTasks = loadTasksFromFile();
+    if (journalReplay(allTasks)) {
+        assignMissingTaskIds(allTasks);
+        invalidateTaskIndex();
+    }
+}
+
+static int runCliAdd(int argc, char** argv) {
+    std::vector<std::string> words;
+    std::string category = cliExtractCategory(argc, argv, 2, words);
+    std::string text;
+    for (auto &w : words) {
+        if (!text.empty()) text += ' ';
+        text += w;
+    }
+    if (text.empty()) {
+        fprintf(stderr, "usage: todo add <task text> [--category=X]\n");
+        return 1;
+    }
+
+    // Deliberately no DB load: the id scheme needs no knowledge of existing
+    // tasks and the journal is append-only.
+    long long id = allocateTaskId();
+    journalAppend("A;" + std::to_string(id) + ";" +
+                  std::to_string(get_unix_timestamp()) + ";" +
+                  category + ";" + text);
+    printf("added %lld\n", id);
+    return 0;
+}
+
+static int runCliDone(int argc, char** argv) {
+    if (argc < 3) {
+        fprintf(stderr, "usage: todo done <number|text substring>\n");
+        return 1;
+    }
+    cliLoadTasks();
+
+    std::string what = argv[2];
+    char* parseEnd = nullptr;
+    long num = strtol(what.c_str(), &parseEnd, 10);
+
+    Task* target = nullptr;
+    if (parseEnd && *parseEnd == '\0' && num > 0) {
+        // 1-based position among open tasks, as printed by `todo list`
+        long seen = 0;
+        for (auto &t : allTasks) {
+            if (t.completed) continue;
+            if (++seen == num) {
+                target = &t;
+                break;
+            }
+        }
+    } else {
+        for (auto &t : allTasks) {
+            if (!t.completed && t.task.find(what) != std::string::npos) {
+                if (target) {
+                    fprintf(stderr, "done: '%s' is ambiguous\n", what.c_str());
+                    return 1;
+                }
+                target = &t;
+            }
+        }
+    }
+    if (!target) {
+        fprintf(stderr, "done: no open task matches '%s'\n", what.c_str());
+        return 1;
+    }
+
+    target->completed = true;
+    target->dates[1] = get_unix_timestamp();
+    journalAppend("C;" + std::to_string(target->id) + ";" +
+                  std::to_string(target->dates[1]));
+    printf("done: %s\n", target->task.c_str());
+    return 0;
+}
+
+static int runCliList(int argc, char** argv) {
+    std::vector<std::string> words;
+    std::string category = cliExtractCategory(argc, argv, 2, words);
+    bool showDone = false;
+    for (auto &w : words) {
+        if (w == "--done") showDone = true;
+    }
+    cliLoadTasks();
+
+    int num = 0;
+    for (auto &t : allTasks) {
+        if (t.completed != showDone) continue;
+        num++;
+        if (!category.empty() && categoryName(t.categoryId) != category) continue;
+        printf("%d\t%s\t%s\n", num, categoryName(t.categoryId).c_str(),
+               t.task.c_str());
+    }
+    return 0;
+}
+#endif // TODO_BENCH
+
+// ---------------------------------------------------------------------------
+// Wrapped-text layout cache.
+//
+// The word-wrap scan (with a substr heap allocation per output line) used to
+// re-run for every visible task on every redraw. Line breaks are now computed
+// once per (task text, column width) and cached as (offset, length) segments;
+// drawing is then a loop of mvwaddnstr calls straight out of the task string.
+// Entries self-invalidate when the column width or text length changes and
+// are dropped explicitly on edit. The cached line counts also make the
+// scroll-offset math correct for multi-line tasks, which it never was.
+// ---------------------------------------------------------------------------
+
+// Compute wrap segments (offset into text, length) for a given width,
+// breaking on word boundaries where possible. Same algorithm the painter
+// always used, minus the allocations.
+static std::vector<std::pair<int, int>> computeWrapSegments(const std::string& text, int width) {
+    std::vector<std::pair<int, int>> segments;
+    int len = (int)text.size();
+    int pos = 0;
+
+    while (pos < len) {
+        int end = pos + width;
+        if (end > len) end = len;
+
+        // Try not to break words
+        if (end < len) {
+            int tmp = end;
+            while (tmp > pos && !std::isspace(static_cast<unsigned char>(text[tmp]))) {
+                tmp--;
+            }
+            if (tmp == pos) {
+                // can't break earlier, just break at 'end'
+                end = pos + width;
+            } else {
+                end = tmp;
+            }
+        }
+
+        int segLen = end - pos;
+        if (segLen > width) {
+            segLen = width;
+        }
+        segments.push_back({pos, segLen});
+
+        // move to the next segment
+        pos = end;
+        while (pos < len && std::isspace(static_cast<unsigned char>(text[pos]))) {
+            pos++;
+        }
+    }
+
+    return segments;
+}
+
+struct TaskLayout {
+    int width = -1;        // wrap width the segments were computed for
+    size_t textLen = 0;    // text size the segments were computed for
+    std::vector<std::pair<int, int>> segments;
+};
+
+static std::unordered_map<long long, TaskLayout> layoutCache;
+
+static const TaskLayout& getTaskLayout(const Task& task, int width) {
+    TaskLayout& entry = layoutCache[task.id];
+    if (entry.width != width || entry.textLen != task.task.size()) {
+        entry.width = width;
+        entry.textLen = task.task.size();
+        entry.segments = computeWrapSegments(task.task, width);
+    }
+    return entry;
+}
+
+// Lines a task occupies at a given wrap width (empty text still takes a row).
+static int taskLineCount(const Task& task, int width) {
+    int n = (int)getTaskLayout(task, width).segments.size();
+    return (n > 0) ? n : 1;
+}
+
+// Draw a task's text from its cached layout. Returns the lines used.
+static int drawWrappedText(WINDOW* win, int startY, int startX, int width, const Task& task) {
+    const TaskLayout& layout = getTaskLayout(task, width);
+    for (size_t i = 0; i < layout.segments.size(); i++) {
+        mvwaddnstr(win, startY + (int)i, startX,
+                   task.task.data() + layout.segments[i].first,
+                   layout.segments[i].second);
+    }
+    return (layout.segments.size() > 0) ? (int)layout.segments.size() : 1;
+}
+
+// Format one timestamp as "%Y-%m-%d %H:%M" with two layers of caching.
+// The display granularity is a minute, so the result is memoized per
+// timestamp-minute; repeated rows in the same minute are one hash lookup.
+// Misses usually stay cheap too: one localtime per calendar day yields the
+// date prefix and the day's start, after which HH:MM for any timestamp in
+// that day is integer arithmetic — localtime itself takes a lock and walks
+// the TZ database, which is what used to run twice per row per redraw.
+// Days containing a UTC-offset change (DST) skip the arithmetic path.
+static const std::string& formatMinuteTs(long long ts) {
+    static std::unordered_map<long long, std::string> minuteCache;
+    long long minute = ts / 60;
+    auto it = minuteCache.find(minute);
+    if (it != minuteCache.end()) return it->second;
+
+    static long long dayStart = 0, dayEnd = 0;  // last precomputed day
+    static bool dayLinear = false;              // no offset change within it
+    static char dayPrefix[16] = "";
+
+    char buf[32];
+    if (dayLinear && ts >= dayStart && ts < dayEnd) {
+        int off = (int)(ts - dayStart); // < 86400 by the range check
+        snprintf(buf, sizeof(buf), "%s %02d:%02d", dayPrefix,
+                 off / 3600, (off / 60) % 60);
+    } else {
+        std::time_t t = (std::time_t)ts;
+        struct tm tmBuf;
+        localtime_r(&t, &tmBuf);
+        std::strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M", &tmBuf);
+
+        // Precompute this day so the next miss in it is arithmetic only
+        dayStart = ts - (tmBuf.tm_hour * 3600LL + tmBuf.tm_min * 60 + tmBuf.tm_sec);
+        dayEnd = dayStart + 86400;
+        std::strftime(dayPrefix, sizeof(dayPrefix), "%Y-%m-%d", &tmBuf);
+        struct tm tmEnd;
+        std::time_t tEnd = (std::time_t)(dayEnd - 1);
+        localtime_r(&tEnd, &tmEnd);
+        dayLinear = (tmEnd.tm_gmtoff == tmBuf.tm_gmtoff);
+    }
+    return minuteCache.emplace(minute, buf).first->second;
+}
+
+// Safely format date/time info for a Task in two columns:
+//   - notification time
+//   - creation/completion time
+// Return a 2-element vector of strings: [reminder_time, relevant_date]
+std::vector<std::string> formatDate(const Task &task) {
+    std::vector<std::string> tuple(2);
+
+    // If the user has scheduled a reminder in the future
+    // (or it might be in the past), let's show that time:
+    long long st = task.notification.scheduledTime;
+
+    // We'll pick `task.dates[0]` if not completed, else `task.dates[1]`.
+    long long date = (task.completed ? task.dates[1] : task.dates[0]);
+
+    // If st == 0, might mean "no reminder set"
+    tuple[0] = (st == 0) ? " " : formatMinuteTs(st);
+    tuple[1] = formatMinuteTs(date);
+    return tuple;
+}
+
+// Per-task cache of the formatted date strings, keyed on task id and
+// self-validating against the raw timestamps, so redraws don't re-run
+// localtime/strftime for rows whose dates haven't changed.
+struct CachedDateStrings {
+    long long reminderTs = -1;
+    long long dateTs = -1;
+    std::string reminder;
+    std::string date;
+};
+
+static std::unordered_map<long long, CachedDateStrings> dateStringCache;
+
+static const CachedDateStrings& getDateStrings(const Task& task) {
+    long long st = task.notification.scheduledTime;
+    long long date = (task.completed ? task.dates[1] : task.dates[0]);
+
+    CachedDateStrings& entry = dateStringCache[task.id];
+    if (entry.reminderTs != st || entry.dateTs != date) {
+        auto strs = formatDate(task);
+        entry.reminderTs = st;
+        entry.dateTs = date;
+        entry.reminder = strs[0];
+        entry.date = strs[1];
+    }
+    return entry;
+}
+
+// ---------------------------------------------------------------------------
+// Full-text search index.
+//
+// '/' opens an incremental search over the task text. Matching is backed by
+// an inverted index: lowercased token -> sorted list of task ids, kept in a
+// std::map so a query word matches any indexed token it prefixes (lower_bound
+// range scan). The index is maintained on add/edit/delete, so a keystroke in
+// search mode costs O(matching postings), not a rescan of every task string.
+// ---------------------------------------------------------------------------
+
+static std::map<std::string, std::vector<long long>> tokenIndex;
+static std::string searchQuery;                      // empty = no search filter
+static std::unordered_set<long long> searchMatches;  // task ids matching the query
+
+// Split text into lowercased alphanumeric tokens (deduplicated).
+static std::vector<std::string> tokenizeText(const std::string& text) {
+    std::vector<std::string> tokens;
+    std::string cur;
+    for (unsigned char c : text) {
+        if (std::isalnum(c)) {
+            cur += (char)std::tolower(c);
+        } else if (!cur.empty()) {
+            tokens.push_back(cur);
+            cur.clear();
+        }
+    }
+    if (!cur.empty()) tokens.push_back(cur);
+
+    std::sort(tokens.begin(), tokens.end());
+    tokens.erase(std::unique(tokens.begin(), tokens.end()), tokens.end());
+    return tokens;
+}
+
+static void indexTaskText(long long id, const std::string& text) {
+    for (auto &tok : tokenizeText(text)) {
+        tokenIndex[tok].push_back(id);
+    }
+}
+
+static void unindexTaskText(long long id, const std::string& text) {
+    for (auto &tok : tokenizeText(text)) {
+        auto it = tokenIndex.find(tok);
+        if (it == tokenIndex.end()) continue;
+        auto &ids = it->second;
+        ids.erase(std::remove(ids.begin(), ids.end(), id), ids.end());
+        if (ids.empty()) {
+            tokenIndex.erase(it);
+        }
+    }
+}
+
+#ifndef TODO_BENCH  // startup only; bench synthesizes tasks and never searches
+static void rebuildSearchIndex() {
+    tokenIndex.clear();
+    for (auto &t : allTasks) {
+        indexTaskText(t.id, t.task);
+    }
+}
+#endif // TODO_BENCH
+
+// Recompute searchMatches for the current query: each query word matches by
+// prefix (union over the map range), and words are ANDed together.
+static void rebuildSearchMatches() {
+    searchMatches.clear();
+    if (searchQuery.empty()) return;
+
+    std::vector<std::string> words = tokenizeText(searchQuery);
+    if (words.empty()) return;
+
+    bool first = true;
+    for (auto &word : words) {
+        // Union of postings for every indexed token starting with `word`.
+        std::unordered_set<long long> wordMatches;
+        for (auto it = tokenIndex.lower_bound(word);
+             it != tokenIndex.end() && it->first.compare(0, word.size(), word) == 0;
+             ++it) {
+            wordMatches.insert(it->second.begin(), it->second.end());
+        }
+
+        if (first) {
+            searchMatches = std::move(wordMatches);
+            first = false;
+        } else {
+            // Intersect with what earlier words matched.
+            for (auto it = searchMatches.begin(); it != searchMatches.end();) {
+                if (wordMatches.count(*it) == 0) {
+                    it = searchMatches.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+        if (searchMatches.empty()) return;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Dirty-region redraw state.
+//
+// drawListUI() used to werase() the window and repaint every visible row —
+// re-running strftime and the word-wrap scan for each — on every cursor move.
+// We now remember where each visible row landed on the last full paint; when
+// nothing changed except the selection (the overwhelmingly common case:
+// arrow keys), only the previously-selected and newly-selected rows are
+// repainted. Anything that changes content, layout, or scroll position sets
+// listDirty and forces a full repaint.
+// ---------------------------------------------------------------------------
+
+struct RowSlot {
+    int filteredPos;  // position within the filtered index list
+    int y;            // first curses row of this task inside listWin
+    int lines;        // rows occupied (wrapped text)
+};
+
+static std::vector<RowSlot> visibleRowSlots;
+static int lastScrollOffset = 0;
+static int lastPaintedSelection = -1;
+static int lastListWidth = -1;
+static int lastListHeight = -1;
+static bool listDirty = true;
+
+static void invalidateListUI() {
+    listDirty = true;
+}
+
+// ---------------------------------------------------------------------------
+// Sort engine.
+//
+// 'o' cycles the display order of the active view. Each (view, mode) pair
+// keeps its computed permutation cached, invalidated only by mutations that
+// can change a sort key or the row set — so flipping between sort modes on a
+// large history reuses the cached ordering instead of re-sorting. All keys
+// are plain integers (timestamps, or a per-rebuild category rank), compared
+// with a stable sort so ties keep file order.
+// ---------------------------------------------------------------------------
+
+enum SortMode {
+    SORT_FILE = 0,   // DB order (the historical default)
+    SORT_CREATED,    // dates[0]
+    SORT_COMPLETED,  // dates[1]
+    SORT_CATEGORY,   // category name rank
+    SORT_REMINDER,   // notification.scheduledTime
+    SORT_MODE_COUNT
+};
+
+static const char* SORT_MODE_NAMES[SORT_MODE_COUNT] = {
+    "file", "created", "completed", "category", "reminder"
+};
+
+static int sortMode = SORT_FILE;
+
+static std::vector<int> sortedPosCache[2][SORT_MODE_COUNT];
+static bool sortCacheDirty[2][SORT_MODE_COUNT] = {
+    {true, true, true, true, true},
+    {true, true, true, true, true},
+};
+
+// Drop every cached permutation (a sort key or the row set changed).
+static void invalidateSortCaches() {
+    for (int v = 0; v < 2; v++) {
+        for (int m = 0; m < SORT_MODE_COUNT; m++) {
+            sortCacheDirty[v][m] = true;
+        }
+    }
+}
+
+// Positions of the active view in display order for the current sort mode.
+static std::vector<int>& getSortedPositions() {
+    std::vector<int>& cache = sortedPosCache[viewMode][sortMode];
+    if (!sortCacheDirty[viewMode][sortMode]) {
+        return cache;
+    }
+    PerfScope perf(PERF_SORT);
+
+    const std::vector<int>& view = activeView();
+    cache.resize(view.size());
+    for (int i = 0; i < (int)view.size(); i++) {
+        cache[i] = i;
+    }
+
+    if (sortMode != SORT_FILE) {
+        // Precompute one integer key per row, then sort the positions.
+        std::vector<long long> keys(view.size());
+
+        std::vector<long long> catRank;
+        if (sortMode == SORT_CATEGORY) {
+            // Rank categories by name once per rebuild; comparing ranks in
+            // the sort keeps the hot comparator integer-only.
+            std::vector<int> ids(categoryTable.size());
+            for (size_t i = 0; i < ids.size(); i++) ids[i] = (int)i;
+            std::sort(ids.begin(), ids.end(), [](int a, int b) {
+                return categoryTable[a] < categoryTable[b];
+            });
+            catRank.resize(ids.size());
+            for (size_t r = 0; r < ids.size(); r++) catRank[ids[r]] = (long long)r;
+        }
+
+        for (size_t i = 0; i < view.size(); i++) {
+            const Task& t = allTasks[view[i]];
+            switch (sortMode) {
+                case SORT_CREATED:   keys[i] = t.dates[0]; break;
+                case SORT_COMPLETED: keys[i] = t.dates[1]; break;
+                case SORT_CATEGORY:  keys[i] = catRank[t.categoryId]; break;
+                case SORT_REMINDER:
+                    // Unset reminders (0) sort last, not first
+                    keys[i] = (t.notification.scheduledTime == 0)
+                                  ? std::numeric_limits<long long>::max()
+                                  : t.notification.scheduledTime;
+                    break;
+                default: break;
+            }
+        }
+        std::stable_sort(cache.begin(), cache.end(), [&keys](int a, int b) {
+            return keys[a] < keys[b];
+        });
+    }
+
+    sortCacheDirty[viewMode][sortMode] = false;
+    return cache;
+}
+
+// ---------------------------------------------------------------------------
+// Cached category-filter index.
+//
+// Every keyboard handler used to rebuild its own filteredIndices vector with
+// a full linear scan and a string compare per task — on every arrow key. The
+// index is now computed once and cached; it is only invalidated when the
+// filter category, the view mode, or the task set actually changes, so
+// navigation is O(1) per keypress regardless of list size.
+// ---------------------------------------------------------------------------
+
+static std::vector<int> filteredIndexCache;
+static bool filterIndexDirty = true;
+
+static void invalidateFilterIndex() {
+    filterIndexDirty = true;
+    // A different row set always needs a full repaint too.
+    invalidateListUI();
+}
+
+// Returns indices (into currentTasks or completedTasks, per viewMode) of the
+// tasks matching activeFilterCategory, rebuilding only when stale.
+static std::vector<int>& getFilteredIndices() {
+    if (filterIndexDirty) {
+        PerfScope perf(PERF_FILTER);
+        const std::vector<int>& view = activeView();
+        filteredIndexCache.clear();
+        filteredIndexCache.reserve(view.size());
+        // Walk view positions in display (sort) order, keeping matches.
+        for (int i : getSortedPositions()) {
+            if (activeFilterCatId >= 0 &&
+                allTasks[view[i]].categoryId != activeFilterCatId) {
+                continue;
+            }
+            if (!searchQuery.empty() &&
+                searchMatches.count(allTasks[view[i]].id) == 0) {
+                continue;
+            }
+            filteredIndexCache.push_back(i);
+        }
+        filterIndexDirty = false;
+    }
+    return filteredIndexCache;
+}
+
+// The view the user is currently looking at.
+static std::vector<int>& activeView() {
+    return (viewMode == 0) ? currentView : completedView;
+}
+
+// Rebuild the current/completed index views from allTasks (after load or a
+// structural change that shifted indices).
+void rebuildViews() {
+    currentView.clear();
+    completedView.clear();
+
+    for (size_t i = 0; i < allTasks.size(); i++) {
+        if (allTasks[i].completed) {
+            completedView.push_back((int)i);
+        } else {
+            currentView.push_back((int)i);
+        }
+    }
+    invalidateSortCaches();
+    invalidateFilterIndex();
+}
+
+// Paint a single task row (item number, category, dates, wrapped text) at a
+// given Y inside listWin. Returns the number of lines used.
+static int drawTaskRow(const Task& task, int displayNum, int y,
+                       bool selected, int reminderColPos, int categoryColumnPos,
+                       int dateColumnPos) {
+    wattron(listWin, COLOR_PAIR(selected ? 2 : 3));
+
+    // Show the item number (1-based), with the bulk-select mark beside it
+    mvwprintw(listWin, y, 2, "%-3d%c", displayNum + 1,
+              markedTaskIds.count(task.id) ? '*' : ' ');
+
+    // Show the category
+    mvwprintw(listWin, y, categoryColumnPos, "%-12s", categoryName(task.categoryId).c_str());
+
+    // The date/time strings (cached per task)
+    const CachedDateStrings& dates = getDateStrings(task);
+    mvwprintw(listWin, y, dateColumnPos, "%s", dates.date.c_str());
+    mvwprintw(listWin, y, reminderColPos, "%s", dates.reminder.c_str());
+
+    // The task text (wrapped, from the cached layout)
+    int linesUsed = drawWrappedText(listWin, y, 6,
+                                    reminderColPos - 7,
+                                    task);
+
+    wattroff(listWin, COLOR_PAIR(selected ? 2 : 3));
+    return linesUsed;
+}
+
+// Draw the list portion of the UI
+static void drawListUI() {
+    int dateColumnPos     = getmaxx(listWin) - 18;
+    int reminderColPos    = getmaxx(listWin) - 56;
+    int categoryColumnPos = getmaxx(listWin) - 36;
+
+    // We will refer to either the current or completed view
+    const std::vector<int> &view = activeView();
+
+    // List of tasks that match activeFilterCategory (cached)
+    std::vector<int>& filteredIndices = getFilteredIndices();
+    // Clamp selectedIndex
+    if (!filteredIndices.empty()) {
+        if (selectedIndex >= (int)filteredIndices.size()) {
+            selectedIndex = (int)filteredIndices.size() - 1;
+        }
+        if (selectedIndex < 0) {
+            selectedIndex = 0;
+        }
+    } else {
+        selectedIndex = 0;
+    }
+
+    int taskCount = (int)filteredIndices.size();
+    int visibleLines = getmaxy(listWin) - 2;
+    int wrapWidth = reminderColPos - 7;
+
+    // Scroll in whole rows, accounting for wrapped (multi-line) tasks via the
+    // cached layouts: the selected row must fit on screen entirely. The old
+    // "selectedIndex - (visibleLines - 1)" math assumed one line per task.
+    static int listScrollOffset = 0;
+    if (listScrollOffset >= taskCount) {
+        listScrollOffset = (taskCount > 0) ? taskCount - 1 : 0;
+    }
+    if (selectedIndex < listScrollOffset) {
+        listScrollOffset = selectedIndex;
+    } else {
+        // Each row is at least one line, so this is a lower bound jump that
+        // keeps the fit-up loop below O(visibleLines).
+        if (selectedIndex - listScrollOffset >= visibleLines) {
+            listScrollOffset = selectedIndex - visibleLines + 1;
+        }
+        int usedLines = 0;
+        for (int i = listScrollOffset; i <= selectedIndex && i < taskCount; i++) {
+            usedLines += taskLineCount(allTasks[view[filteredIndices[i]]], wrapWidth);
+        }
+        while (usedLines > visibleLines && listScrollOffset < selectedIndex) {
+            usedLines -= taskLineCount(allTasks[view[filteredIndices[listScrollOffset]]],
+                                       wrapWidth);
+            listScrollOffset++;
+        }
+    }
+    int scrollOffset = listScrollOffset;
+
+    // Fast path: nothing changed but the selection, and both the old and new
+    // selected rows are still on screen — repaint just those two rows.
+    if (!listDirty && scrollOffset == lastScrollOffset &&
+        getmaxx(listWin) == lastListWidth && getmaxy(listWin) == lastListHeight &&
+        lastPaintedSelection >= 0) {
+        const RowSlot* oldSlot = nullptr;
+        const RowSlot* newSlot = nullptr;
+        for (const auto& slot : visibleRowSlots) {
+            if (slot.filteredPos == lastPaintedSelection) oldSlot = &slot;
+            if (slot.filteredPos == selectedIndex) newSlot = &slot;
+        }
+        if (oldSlot && newSlot) {
+            if (selectedIndex != lastPaintedSelection) {
+                int oldReal = filteredIndices[oldSlot->filteredPos];
+                int newReal = filteredIndices[newSlot->filteredPos];
+                drawTaskRow(allTasks[view[oldReal]], oldReal, oldSlot->y,
+                            false, reminderColPos, categoryColumnPos, dateColumnPos);
+                drawTaskRow(allTasks[view[newReal]], newReal, newSlot->y,
+                            true, reminderColPos, categoryColumnPos, dateColumnPos);
+                lastPaintedSelection = selectedIndex;
+            }
+            wnoutrefresh(stdscr);
+            wnoutrefresh(listWin);
+            return;
+        }
+        // Selection scrolled off the slot map: fall through to a full paint.
+    }
+
+    // Full repaint
+    const char* colnames = (viewMode == 0) ? " Current Tasks " : " Completed Tasks ";
+    const char* colcat   = " Category ";
+    const char* coldates = (viewMode == 0) ? " Added on " : " Completed on ";
+    const char* reminder = " Reminder ";
+
+    werase(listWin);
+    box(listWin, 0, 0);
+
+    // top line inside the box
+    mvwprintw(listWin, 0, 2, " # ");
+    mvwprintw(listWin, 0, 6, "%s", colnames);
+    mvwprintw(listWin, 0, reminderColPos, "%s", reminder);
+    mvwprintw(listWin, 0, categoryColumnPos, "%s", colcat);
+    mvwprintw(listWin, 0, dateColumnPos, "%s", coldates);
+
+    visibleRowSlots.clear();
+    int currentY = 1;
+    for (int idx = scrollOffset; idx < taskCount; idx++) {
+        if (currentY >= getmaxy(listWin) - 1) {
+            break;
+        }
+        int realIndex = filteredIndices[idx];
+        int linesUsed = drawTaskRow(allTasks[view[realIndex]], realIndex, currentY,
+                                    idx == selectedIndex, reminderColPos,
+                                    categoryColumnPos, dateColumnPos);
+        visibleRowSlots.push_back({idx, currentY, linesUsed});
+        currentY += linesUsed;
+    }
+
+    listDirty = false;
+    lastScrollOffset = scrollOffset;
+    lastPaintedSelection = selectedIndex;
+    lastListWidth = getmaxx(listWin);
+    lastListHeight = getmaxy(listWin);
+
+    wnoutrefresh(stdscr);
+    wnoutrefresh(listWin);
+}
+
+// One status line of live timings at the bottom of stdscr.
+static void drawPerfHud() {
+    mvprintw(LINES - 1, 2,
+             "perf us (avg/p99): frame %lld/%lld  draw %lld/%lld  "
+             "sort %lld/%lld  filter %lld/%lld   P=dump",
+             perfAvg(perfRings[PERF_FRAME]), perfPercentile(perfRings[PERF_FRAME], 99),
+             perfAvg(perfRings[PERF_DRAW]), perfPercentile(perfRings[PERF_DRAW], 99),
+             perfAvg(perfRings[PERF_SORT]), perfPercentile(perfRings[PERF_SORT], 99),
+             perfAvg(perfRings[PERF_FILTER]), perfPercentile(perfRings[PERF_FILTER], 99));
+    clrtoeol();
+}
+
+static void drawUI() {
+    PerfScope perf(PERF_DRAW);
+    // Draw header on stdscr
+    wattron(stdscr, COLOR_PAIR(3));
+    mvprintw(1, 2, "CLI TODO APP");
+    mvprintw(2, 2, "Current Tasks: %zu | Completed Tasks: %zu",
+             currentView.size(), completedView.size());
+    mvhline(3, 2, ACS_HLINE, COLS - 4);
+    mvprintw(4, 2, "Keys: c=complete, d=delete, n=add, s=category, r=reminder, e=edit, u/U=undo/redo, Space=mark, #:filter, /=search, o=sort, Tab=switch, q=save+exit");
+    mvprintw(5, 2, "Nav: Up/Down, PgUp/PgDn, Home/End, Goto ':<num>'");
+    mvprintw(6, 2, "Category Filter: %s | Search: %s | Sort: %s                 ",
+             activeFilterCategory.c_str(),
+             searchQuery.empty() ? "-" : searchQuery.c_str(),
+             SORT_MODE_NAMES[sortMode]);
+    wattroff(stdscr, COLOR_PAIR(3));
+    if (perfHudEnabled) drawPerfHud();
+
+    drawListUI();
+}
+
+// ---------------------------------------------------------------------------
+// Undo/redo.
+//
+// Every mutation is recorded as a compact delta: just the task id and the
+// field the op touched, plus a full Task copy only for add/delete (where
+// one side of the operation needs the whole thing back). History therefore
+// costs bytes per keypress rather than snapshots of the task vectors, and
+// the deltas line up one-to-one with the journal records already written.
+// ---------------------------------------------------------------------------
+
+struct MutationDelta {
+    char op;                          // 'A' add, 'C' complete, 'E' edit,
+                                      // 'D' delete, 'G' recategorize
+    long long taskId = 0;
+    std::string oldText, newText;     // 'E'
+    int oldCatId = 0, newCatId = 0;   // 'G'
+    long long completedAt = 0;        // 'C'
+    Task snapshot;                    // 'A' as added / 'D' as deleted
+};
+
+static std::vector<MutationDelta> undoStack;
+static std::vector<MutationDelta> redoStack;
+
+// A fresh user mutation invalidates whatever was undone before it.
+static void recordMutation(MutationDelta&& d) {
+    undoStack.push_back(std::move(d));
+    redoStack.clear();
+}
+
+static void undoMutation();
+static void redoMutation();
+
+// Overlay to add a new task
+static void addTaskOverlay() {
+    int overlayHeight = 7;
+    int overlayWidth = COLS - 20;
+    int overlayY = (LINES - overlayHeight) / 2;
+    int overlayX = (COLS - overlayWidth) / 2;
+
+    WINDOW* overlayWin = newwin(overlayHeight, overlayWidth, overlayY, overlayX);
+    wbkgd(overlayWin, COLOR_PAIR(3));
+    box(overlayWin, 0, 0);
+    mvwprintw(overlayWin, 1, 2, "Enter new task:");
+    wrefresh(overlayWin);
+
+    Task new_task;
+    new_task.task = ncursesGetString(overlayWin, 2, 2, 1024);
+
+    if (!new_task.task.empty()) {
+        new_task.id = allocateTaskId();
+        // Set creation time
+        new_task.dates[0] = get_unix_timestamp();
+        new_task.dates[1] = 0; // not completed yet
+        new_task.completed = false;
+        // Insert it into the master list and the current view
+        allTasks.push_back(new_task);
+        currentView.push_back((int)allTasks.size() - 1);
+
+        journalAppend("A;" + std::to_string(new_task.id) + ";" +
+                      std::to_string(new_task.dates[0]) + ";" +
+                      categoryName(allTasks.back().categoryId) + ";" + new_task.task);
+        MutationDelta delta;
+        delta.op = 'A';
+        delta.taskId = new_task.id;
+        delta.snapshot = new_task;
+        recordMutation(std::move(delta));
+        indexTaskText(new_task.id, new_task.task);
+        if (!searchQuery.empty()) rebuildSearchMatches();
+        invalidateSortCaches();
+        invalidateFilterIndex();
+        invalidateTaskIndex();
+    }
+    delwin(overlayWin);
+}
+
+
+// Overlay to add a new task
+std::string editTaskOverlay(Task task) {
+    int overlayHeight = 7;
+    int overlayWidth = COLS - 20;
     int overlayY = (LINES - overlayHeight) / 2;
     int overlayX = (COLS - overlayWidth) / 2;
     WINDOW* overlayWin = newwin(overlayHeight, overlayWidth, overlayY, overlayX);
@@ -517,8 +2498,7 @@ static void addCategoryOverlay(int taskIndex, bool forCompleted) {
     box(overlayWin, 0, 0);
 
     // Grab a reference to the actual Task we want
-    Task &theTask = (forCompleted ? completedTasks[taskIndex]
-                                  : currentTasks[taskIndex]);
+    Task &theTask = allTasks[(forCompleted ? completedView : currentView)[taskIndex]];
 
     mvwprintw(overlayWin, 1, 2, "Enter category for %s item #%d:",
               (forCompleted ? "completed" : "current"), taskIndex+1);
@@ -526,15 +2506,16 @@ static void addCategoryOverlay(int taskIndex, bool forCompleted) {
     wmove(overlayWin, 2, 2);
     wrefresh(overlayWin);
     // Pre-fill existing category
-    waddstr(overlayWin, theTask.category.c_str());
+    waddstr(overlayWin, categoryName(theTask.categoryId).c_str());
     wrefresh(overlayWin);
 
-    std::string newCat = ncursesGetString(overlayWin, 2, 2, 1024, theTask.category);
+    std::string newCat = ncursesGetString(overlayWin, 2, 2, 1024,
+                                          categoryName(theTask.categoryId));
     if (!newCat.empty()) {
         if (newCat.size() >= 17) {
             newCat.erase(newCat.size() - 17);  // Remove the last 17 characters safely
         }
-        theTask.category = newCat;
+        theTask.categoryId = internCategory(newCat);
 
     }
     delwin(overlayWin);
@@ -542,21 +2523,12 @@ static void addCategoryOverlay(int taskIndex, bool forCompleted) {
 
 // Overlay listing categories to filter
 static void listCategoriesOverlay() {
-    // We gather categories from whichever vector we are viewing
-    const std::vector<Task> &vec = (viewMode == 0) ? currentTasks : completedTasks;
-
-    std::set<std::string> uniqueCats;
-    for (auto &t : vec) {
-        if (!t.category.empty()) {
-            uniqueCats.insert(t.category);
-        }
-    }
-
-    // put them in a vector for indexing
+    // The interned table already is the unique-category list; no per-open
+    // set rebuild needed. Entry 0 is the empty category, skipped here.
     std::vector<std::string> catList;
     catList.push_back("All");
-    for (auto &c : uniqueCats) {
-        catList.push_back(c);
+    for (size_t i = 1; i < categoryTable.size(); i++) {
+        catList.push_back(categoryTable[i]);
     }
 
     int overlayHeight = 5 + (int)catList.size();
@@ -610,6 +2582,8 @@ static void listCategoriesOverlay() {
             break;
         } else if (ch == '\n' || ch == '\r') {
             activeFilterCategory = catList[catSelected];
+            activeFilterCatId = (catSelected == 0) ? -1
+                                                   : internCategory(catList[catSelected]);
             break;
         }
     }
@@ -619,38 +2593,32 @@ static void listCategoriesOverlay() {
 
 static void completeTask() {
     if (viewMode != 0) return;  // only valid in current-view
-    if (currentTasks.empty()) return;
+    if (currentView.empty()) return;
 
-    // Build filteredIndices
-    std::vector<int> filteredIndices;
-    for (int i = 0; i < (int)currentTasks.size(); i++) {
-        if (activeFilterCategory == "All" || currentTasks[i].category == activeFilterCategory) {
-            filteredIndices.push_back(i);
-        }
-    }
+    std::vector<int>& filteredIndices = getFilteredIndices();
     if (filteredIndices.empty()) return;
     if (selectedIndex >= (int)filteredIndices.size()) return;
 
-    int realIndex = filteredIndices[selectedIndex];
-    // Mark it completed
-    Task t = currentTasks[realIndex];
+    int viewPos = filteredIndices[selectedIndex];
+    int masterIndex = currentView[viewPos];
+
+    // Mark it completed (in place; there is only one copy)
+    Task &t = allTasks[masterIndex];
     t.completed = true;
     t.dates[1] = get_unix_timestamp();
 
-    // Also update in allTasks
-    // We can find it by pointer or by some ID, but for simplicity:
-    for (int i = 0; i < allTasks.size(); i++) {
-
-        if (allTasks[i].dates[0] == t.dates[0]) {
-            allTasks[i].completed = true;
-            allTasks[i].dates[1] = t.dates[1];
-            break;
-        }
-    }
+    journalAppend("C;" + std::to_string(t.id) + ";" + std::to_string(t.dates[1]));
+    MutationDelta delta;
+    delta.op = 'C';
+    delta.taskId = t.id;
+    delta.completedAt = t.dates[1];
+    recordMutation(std::move(delta));
 
-    // Move from currentTasks to completedTasks
-    completedTasks.push_back(t);
-    currentTasks.erase(currentTasks.begin() + realIndex);
+    // Move the index from the current view to the completed view
+    completedView.push_back(masterIndex);
+    currentView.erase(currentView.begin() + viewPos);
+    invalidateSortCaches();
+    invalidateFilterIndex();
 
     // Adjust index if needed
     if (selectedIndex >= (int)filteredIndices.size()) {
@@ -662,98 +2630,294 @@ static void completeTask() {
 
 
 void editTask() {
-    const std::vector<Task>& temp = (viewMode == 0) ? currentTasks : completedTasks;
-    std::vector<int> filteredIndices;
-
-    for (int i = 0; i < (int)temp.size(); i++) {
-        if (activeFilterCategory == "All" || temp[i].category == activeFilterCategory) {
-            filteredIndices.push_back(i);
-        }
-    }
+    std::vector<int>& filteredIndices = getFilteredIndices();
 
     if (!filteredIndices.empty() && selectedIndex < (int)filteredIndices.size()) {
-        int realIndex = filteredIndices[selectedIndex];
-
-        std::string edited_task;
-        
-        if (viewMode == 0) {
-            // Edit current tasks
-            Task& updated = currentTasks[realIndex];  // Use reference to modify directly
-            edited_task = editTaskOverlay(updated);
-            updated.task = edited_task;  // Apply changes
-
-            // Update the corresponding task in allTasks
-            for (Task& task : allTasks) {
-                if (task.dates[0] == updated.dates[0]) {
-                    task.task = edited_task;
-                }
-            }
-        } else {
-            // Edit completed tasks
-            Task& updated = completedTasks[realIndex];  // Use reference to modify directly
-            edited_task = editTaskOverlay(updated);
-            updated.task = edited_task;  // Apply changes
-
-            // Update the corresponding task in allTasks
-            for (Task& task : allTasks) {
-                if (task.dates[0] == updated.dates[0]) {
-                    task.task = edited_task;
-                }
-            }
+        int viewPos = filteredIndices[selectedIndex];
+
+        // There is only one copy of the task, so edit it in place
+        Task& updated = allTasks[activeView()[viewPos]];
+        touchArchived(updated);
+        std::string oldText = updated.task;
+        unindexTaskText(updated.id, updated.task);
+        updated.task = editTaskOverlay(updated);
+        indexTaskText(updated.id, updated.task);
+        if (updated.task != oldText) {
+            MutationDelta delta;
+            delta.op = 'E';
+            delta.taskId = updated.id;
+            delta.oldText = std::move(oldText);
+            delta.newText = updated.task;
+            recordMutation(std::move(delta));
+            // Guarded like the delta: a cancelled or no-op edit must not
+            // reach the sync log, where its fresh timestamp re-asserting
+            // the old text could beat a peer's real edit under LWW.
+            journalAppend("E;" + std::to_string(updated.id) + ";" +
+                          updated.task);
+        }
+        layoutCache.erase(updated.id);  // line breaks are stale now
+        if (!searchQuery.empty()) {
+            rebuildSearchMatches();
+            invalidateFilterIndex();
         }
     }
 }
 
 
 static void deleteTask() {
-    // Decide which vector to remove from
-    std::vector<Task> &vec = (viewMode == 0) ? currentTasks : completedTasks;
-    if (vec.empty()) return;
+    std::vector<int> &view = activeView();
+    if (view.empty()) return;
 
-    std::vector<int> filteredIndices;
-    for (int i = 0; i < (int)vec.size(); i++) {
-        if (activeFilterCategory == "All" || vec[i].category == activeFilterCategory) {
-            filteredIndices.push_back(i);
-        }
-    }
+    std::vector<int>& filteredIndices = getFilteredIndices();
     if (filteredIndices.empty()) return;
     if (selectedIndex >= (int)filteredIndices.size()) return;
 
-    int realIndex = filteredIndices[selectedIndex];
+    int viewPos = filteredIndices[selectedIndex];
+    int masterIndex = view[viewPos];
+
+    touchArchived(allTasks[masterIndex]);
+    journalAppend("D;" + std::to_string(allTasks[masterIndex].id));
+    MutationDelta delta;
+    delta.op = 'D';
+    delta.taskId = allTasks[masterIndex].id;
+    delta.snapshot = allTasks[masterIndex];
+    recordMutation(std::move(delta));
+    unindexTaskText(allTasks[masterIndex].id, allTasks[masterIndex].task);
+    // The task takes its reminder with it
+    if (!cancelNotification(allTasks[masterIndex].id)) {
+        saveNotifications();
+    }
+
+    int oldFilteredCount = (int)filteredIndices.size();
+
+    // Erasing from allTasks shifts every later index, so rebuild the views
+    allTasks.erase(allTasks.begin() + masterIndex);
+    invalidateTaskIndex();
+    rebuildViews();
+
+    if (selectedIndex >= oldFilteredCount - 1) {
+        selectedIndex = oldFilteredCount - 2;
+    }
+    if (selectedIndex < 0) selectedIndex = 0;
+}
+
+// Re-insert a task from a delta snapshot and journal the records a replay
+// would need to recreate it (the A record alone loses completion/category/
+// reminder state).
+static void restoreTask(const Task& t) {
+    allTasks.push_back(t);
+    indexTaskText(t.id, t.task);
+    invalidateTaskIndex();
+
+    journalAppend("A;" + std::to_string(t.id) + ";" +
+                  std::to_string(t.dates[0]) + ";" +
+                  categoryName(t.categoryId) + ";" + t.task);
+    if (t.completed) {
+        journalAppend("C;" + std::to_string(t.id) + ";" +
+                      std::to_string(t.dates[1]));
+    }
+    if (t.notification.scheduledTime != 0) {
+        journalAppend("R;" + std::to_string(t.id) + ";" +
+                      std::to_string(t.notification.scheduledTime) + ";" +
+                      std::to_string(t.notification.repeatInterval) + ";" +
+                      std::to_string(t.notification.repeatWeekdays));
+        // Undoing the delete resurrects the reminder too
+        Notification n = t.notification;
+        n.taskId = t.id;
+        n.message = t.task;
+        notifications[t.id] = n;
+    }
+}
 
-    // Keep pointer so we can find it in allTasks
-    Task delTask = vec[realIndex];
+static void removeTaskById(long long id) {
+    int idx = findTaskIndexById(id);
+    if (idx < 0) return;
+    touchArchived(allTasks[idx]);
+    journalAppend("D;" + std::to_string(id));
+    unindexTaskText(id, allTasks[idx].task);
+    allTasks.erase(allTasks.begin() + idx);
+    invalidateTaskIndex();
+    if (!cancelNotification(id)) saveNotifications();
+}
 
-    // Remove from the "master" allTasks as well
-    // (One simple approach: compare addresses or compare a unique field like creation time + task text)
-    for (int i = 0; i < (int)allTasks.size(); i++) {
-        if (allTasks[i].dates[0] == delTask.dates[0]) {
-            allTasks.erase(allTasks.begin() + i);
+// Play one side of a delta: reverse=true walks the mutation backwards
+// (undo), false replays it (redo). Both directions journal what they
+// change so crash recovery sees the same history the user does.
+static void applyDelta(const MutationDelta& d, bool reverse) {
+    switch (d.op) {
+        case 'A':
+            if (reverse) removeTaskById(d.taskId);
+            else restoreTask(d.snapshot);
+            break;
+        case 'D':
+            if (reverse) restoreTask(d.snapshot);
+            else removeTaskById(d.taskId);
+            break;
+        case 'C': {
+            Task* t = findTaskById(d.taskId);
+            if (!t) break;
+            t->completed = !reverse;
+            t->dates[1] = reverse ? 0 : d.completedAt;
+            journalAppend("C;" + std::to_string(d.taskId) + ";" +
+                          std::to_string(t->dates[1]));
+            break;
+        }
+        case 'E': {
+            Task* t = findTaskById(d.taskId);
+            if (!t) break;
+            touchArchived(*t);
+            unindexTaskText(t->id, t->task);
+            t->task = reverse ? d.oldText : d.newText;
+            indexTaskText(t->id, t->task);
+            layoutCache.erase(t->id);
+            journalAppend("E;" + std::to_string(d.taskId) + ";" + t->task);
             break;
         }
+        case 'G': {
+            Task* t = findTaskById(d.taskId);
+            if (!t) break;
+            touchArchived(*t);
+            t->categoryId = reverse ? d.oldCatId : d.newCatId;
+            journalAppend("G;" + std::to_string(d.taskId) + ";" +
+                          categoryName(t->categoryId));
+            break;
+        }
+        default:
+            break;
+    }
+    // Any of the above can move tasks between views, reorder a sort, or
+    // change what the filter/search matches; rebuild once per keypress.
+    rebuildViews();
+    if (!searchQuery.empty()) rebuildSearchMatches();
+    if (selectedIndex >= (int)getFilteredIndices().size()) {
+        selectedIndex = (int)getFilteredIndices().size() - 1;
+    }
+    if (selectedIndex < 0) selectedIndex = 0;
+    invalidateListUI();
+}
+
+static void undoMutation() {
+    if (undoStack.empty()) return;
+    MutationDelta d = std::move(undoStack.back());
+    undoStack.pop_back();
+    applyDelta(d, true);
+    redoStack.push_back(std::move(d));
+}
+
+static void redoMutation() {
+    if (redoStack.empty()) return;
+    MutationDelta d = std::move(redoStack.back());
+    redoStack.pop_back();
+    applyDelta(d, false);
+    undoStack.push_back(std::move(d));
+}
+
+// ---------------------------------------------------------------------------
+// Bulk operations.
+//
+// Space marks rows (tracked by task id, so marks survive re-sorts); c/d/s
+// then apply to the whole marked set in a single pass over allTasks with one
+// view rebuild, one cache invalidation and one redraw at the end — instead
+// of twenty keypresses each paying an O(n) scan, erase shift and repaint.
+// The per-task journal records all land in one writer-thread drain, so the
+// batch costs one fsync. Esc clears the marks.
+// ---------------------------------------------------------------------------
+
+static void bulkComplete() {
+    long long now = get_unix_timestamp();
+    bool any = false;
+    for (auto &t : allTasks) {
+        if (markedTaskIds.count(t.id) == 0 || t.completed) continue;
+        t.completed = true;
+        t.dates[1] = now;
+        journalAppend("C;" + std::to_string(t.id) + ";" + std::to_string(now));
+        MutationDelta delta;
+        delta.op = 'C';
+        delta.taskId = t.id;
+        delta.completedAt = now;
+        recordMutation(std::move(delta));
+        any = true;
+    }
+    markedTaskIds.clear();
+    if (any) rebuildViews(); // one pass; invalidates sort + filter caches too
+    invalidateListUI();
+}
+
+static void bulkDelete() {
+    bool any = false;
+    bool notifDirty = false;
+    // Single remove_if pass: every survivor shifts at most once, instead of
+    // one O(n) erase per deleted task.
+    allTasks.erase(std::remove_if(allTasks.begin(), allTasks.end(), [&](Task& t) {
+        if (markedTaskIds.count(t.id) == 0) return false;
+        touchArchived(t);
+        journalAppend("D;" + std::to_string(t.id));
+        MutationDelta delta;
+        delta.op = 'D';
+        delta.taskId = t.id;
+        delta.snapshot = t;
+        recordMutation(std::move(delta));
+        unindexTaskText(t.id, t.task);
+        if (!cancelNotification(t.id)) notifDirty = true;
+        any = true;
+        return true;
+    }), allTasks.end());
+    markedTaskIds.clear();
+    if (notifDirty) saveNotifications();  // daemon down: persist the drops
+    if (any) {
+        invalidateTaskIndex();
+        rebuildViews();
+        if (!searchQuery.empty()) rebuildSearchMatches();
     }
+    invalidateListUI();
+}
+
+static void bulkRecategorize() {
+    int overlayHeight = 7;
+    int overlayWidth = COLS - 20;
+    int overlayY = (LINES - overlayHeight) / 2;
+    int overlayX = (COLS - overlayWidth) / 2;
+
+    WINDOW* overlayWin = newwin(overlayHeight, overlayWidth, overlayY, overlayX);
+    wbkgd(overlayWin, COLOR_PAIR(3));
+    box(overlayWin, 0, 0);
+    mvwprintw(overlayWin, 1, 2, "Enter category for %zu marked tasks:",
+              markedTaskIds.size());
+    wrefresh(overlayWin);
+
+    std::string newCat = ncursesGetString(overlayWin, 2, 2, 1024);
+    delwin(overlayWin);
+    if (newCat.empty()) return; // cancelled; marks stay
 
-    vec.erase(vec.begin() + realIndex);
+    if (newCat.size() >= 17) {
+        newCat.erase(newCat.size() - 17);  // same cap as the single-task overlay
+    }
+    int catId = internCategory(newCat);
 
-    if (selectedIndex >= (int)filteredIndices.size()) {
-        selectedIndex = (int)filteredIndices.size() - 1;
+    for (auto &t : allTasks) {
+        if (markedTaskIds.count(t.id) == 0 || t.categoryId == catId) continue;
+        touchArchived(t);
+        MutationDelta delta;
+        delta.op = 'G';
+        delta.taskId = t.id;
+        delta.oldCatId = t.categoryId;
+        delta.newCatId = catId;
+        recordMutation(std::move(delta));
+        t.categoryId = catId;
+        journalAppend("G;" + std::to_string(t.id) + ";" + newCat);
     }
-    if (selectedIndex < 0) selectedIndex = 0; 
+    markedTaskIds.clear();
+    invalidateSortCaches();
+    invalidateFilterIndex();
 }
 
 static void gotoItem(int itemNum) {
     // itemNum is 1-based, let's make it 0-based
     itemNum -= 1;
 
-    const std::vector<Task> &vec = (viewMode == 0) ? currentTasks : completedTasks;
-    if (itemNum < 0 || itemNum >= (int)vec.size()) return;
+    if (itemNum < 0 || itemNum >= (int)activeView().size()) return;
 
-    std::vector<int> filteredIndices;
-    for (int i = 0; i < (int)vec.size(); i++) {
-        if (activeFilterCategory == "All" || vec[i].category == activeFilterCategory) {
-            filteredIndices.push_back(i);
-        }
-    }
+    std::vector<int>& filteredIndices = getFilteredIndices();
     for (int fi = 0; fi < (int)filteredIndices.size(); fi++) {
         if (filteredIndices[fi] == itemNum) {
             selectedIndex = fi;
@@ -763,39 +2927,157 @@ static void gotoItem(int itemNum) {
 }
 
 
-// Overlay to set an initial reminder time
-void addNotification(long long scheduled_time) {
-    if (viewMode != 0) return;  // only valid in current-view
-    if (currentTasks.empty()) return;
-
-    // Build filteredIndices
-    std::vector<int> filteredIndices;
-    for (int i = 0; i < (int)currentTasks.size(); i++) {
-        if (activeFilterCategory == "All" || currentTasks[i].category == activeFilterCategory) {
-            filteredIndices.push_back(i);
-        }
+// ---------------------------------------------------------------------------
+// IPC to the daemon.
+//
+// New reminders used to reach the daemon by rewriting notifications.db and
+// waiting for it to notice — and the TUI re-read the whole file on every
+// keypress just to stay fresh. Now the TUI pushes the event over the
+// daemon's unix socket and waits for a short ack; the file write remains
+// only as a fallback for when the daemon isn't running.
+// ---------------------------------------------------------------------------
+
+// Send one message to the daemon; returns true when the daemon acked it.
+static bool sendToDaemon(const std::string& msg) {
+    int fd = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+    if (fd < 0) return false;
+
+    struct sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, DAEMON_SOCKET.c_str(), sizeof(addr.sun_path) - 1);
+
+    // Never let a wedged daemon hang the UI.
+    struct timeval tv = {1, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return false;
+    }
+    if (send(fd, msg.data(), msg.size(), 0) != (ssize_t)msg.size()) {
+        close(fd);
+        return false;
     }
+    char ack[8];
+    ssize_t n = recv(fd, ack, sizeof(ack), 0);
+    close(fd);
+    return (n >= 2 && ack[0] == 'O' && ack[1] == 'K');
+}
+
+// Did the last reminder reach the daemon over the socket? If so the 'r'
+// handler skips the notifications.db rewrite (the daemon persists it).
+static bool reminderSentViaIpc = false;
+
+// Set (or reschedule) the selected task's reminder. The keyed store makes
+// this an upsert: a second reminder on the same task replaces the first
+// instead of appending a dead entry next to it.
+void addNotification(long long scheduled_time, long long repeat_interval,
+                     int repeat_weekdays) {
+    if (viewMode != 0) return;  // only valid in current-view
+    if (currentView.empty()) return;
 
+    std::vector<int>& filteredIndices = getFilteredIndices();
     if (filteredIndices.empty()) return;
     if (selectedIndex >= (int)filteredIndices.size()) return;
 
-    int realIndex = filteredIndices[selectedIndex];
-
-    Task t = currentTasks[realIndex];
+    Task &t = allTasks[currentView[filteredIndices[selectedIndex]]];
     t.notification.scheduledTime = scheduled_time;
+    t.notification.triggered = false;
+    t.notification.repeatInterval = repeat_interval;
+    t.notification.repeatWeekdays = repeat_weekdays;
+    t.notification.taskId = t.id;
     t.notification.message = t.task;
 
-    for (int i = 0; i < allTasks.size(); i++) {
-        if (allTasks[i].dates[0] == t.dates[0]) {
-            allTasks[i] = t;
+    notifications[t.id] = t.notification;
+    journalAppend("R;" + std::to_string(t.id) + ";" +
+                  std::to_string(scheduled_time) + ";" +
+                  std::to_string(repeat_interval) + ";" +
+                  std::to_string(repeat_weekdays));
+
+    // The wire tail is the same schema suffix the daemon parses the file with
+    std::string ipc = "ADD;" + std::to_string(scheduled_time) + ";";
+    schema::formatTextRecord<schema::NOTIFICATION_TAIL_FIELD>(
+        ipc, t.notification, schema::NOTIFICATION_FIELDS,
+        t.notification.message);
+    reminderSentViaIpc = sendToDaemon(ipc);
+
+    invalidateSortCaches();  // the reminder sort key changed
+    invalidateFilterIndex();
+};
+
+// Drop a task's reminder from the keyed store and tell the daemon to forget
+// it. Returns true when nothing needs persisting on our side (no entry, or
+// the daemon acked and owns the file write); false means the caller should
+// fall back to rewriting notifications.db itself.
+static bool cancelNotification(long long taskId) {
+    if (notifications.erase(taskId) == 0) return true;
+    return sendToDaemon("CANCEL;" + std::to_string(taskId));
+}
+
+// Cancel the selected task's reminder ('r' then 0/blank). Journals the
+// zeroed reminder so replay and sync agree the rule is gone.
+static void cancelSelectedReminder() {
+    if (viewMode != 0) return;
+    if (currentView.empty()) return;
+
+    std::vector<int>& filteredIndices = getFilteredIndices();
+    if (filteredIndices.empty()) return;
+    if (selectedIndex >= (int)filteredIndices.size()) return;
+
+    Task &t = allTasks[currentView[filteredIndices[selectedIndex]]];
+    if (t.notification.scheduledTime == 0) return;
+    t.notification = Notification{};
+
+    journalAppend("R;" + std::to_string(t.id) + ";0;0;0");
+    reminderSentViaIpc = cancelNotification(t.id);
+    invalidateSortCaches();
+    invalidateFilterIndex();
+}
+
+
+// Incremental search on the bottom line: the list narrows keystroke by
+// keystroke. Enter keeps the match filter active; ESC clears it.
+static void searchPrompt() {
+    searchQuery.clear();
+    rebuildSearchMatches();
+    invalidateFilterIndex();
+    selectedIndex = 0;
+
+    while (true) {
+        drawUI();
+        mvprintw(LINES - 1, 0, "Search: %s", searchQuery.c_str());
+        clrtoeol();
+        wnoutrefresh(stdscr);
+        doupdate();
+
+        int ch = wgetch(stdscr);
+        if (ch == '\n' || ch == '\r') {
             break;
+        } else if (ch == 27) {
+            // ESC = cancel the search filter entirely
+            searchQuery.clear();
+        } else if (ch == KEY_BACKSPACE || ch == 127 || ch == '\b') {
+            if (!searchQuery.empty()) {
+                searchQuery.pop_back();
+            }
+        } else if (ch >= 32 && ch < 127) {
+            searchQuery += (char)ch;
+        } else {
+            continue;
         }
-    }
 
-    currentTasks[realIndex] = t;
-    notifications.push_back(t.notification);
-};
+        rebuildSearchMatches();
+        invalidateFilterIndex();
+        selectedIndex = 0;
+        if (ch == 27) break;
+    }
 
+    mvprintw(LINES - 1, 0, " ");
+    clrtoeol();
+    invalidateListUI();
+}
 
 // Overlay to set an initial reminder time
 void setReminderOverlay() {
@@ -808,7 +3090,7 @@ void setReminderOverlay() {
     wbkgd(overlayWin, COLOR_PAIR(3));
     box(overlayWin, 0, 0);
 
-    mvwprintw(overlayWin, 1, 2, "Set reminder quantity (integer):");
+    mvwprintw(overlayWin, 1, 2, "Set reminder quantity (integer, 0 = cancel):");
     wmove(overlayWin, 2, 2);
     wrefresh(overlayWin);
 
@@ -820,6 +3102,13 @@ void setReminderOverlay() {
         quantity = 0;
     }
 
+    // Blank or zero removes any existing reminder on the selected task.
+    if (quantity <= 0) {
+        cancelSelectedReminder();
+        delwin(overlayWin);
+        return;
+    }
+
     mvwprintw(overlayWin, 3, 2, "Choose unit: (s)econds, (m)inutes, (h)ours, (d)ays");
     wrefresh(overlayWin);
     char unitCh = wgetch(overlayWin);
@@ -832,11 +3121,408 @@ void setReminderOverlay() {
 
     long long scheduledTime = (long long)now + offsetSeconds;
 
-    addNotification(scheduledTime);
+    mvwprintw(overlayWin, 4, 2, "Repeat: (n)one, (d)aily, (w)eekdays, (e)very %lld%c",
+              quantity, unitCh);
+    wrefresh(overlayWin);
+    char repeatCh = wgetch(overlayWin);
+    if (repeatCh >= 'A' && repeatCh <= 'Z') {
+        repeatCh = repeatCh - 'A' + 'a';
+    }
+
+    long long repeatInterval = 0;
+    int repeatWeekdays = 0;
+    switch (repeatCh) {
+        case 'd': repeatInterval = 86400; break;
+        case 'w': repeatInterval = 86400; repeatWeekdays = 0x3E; break; // Mon-Fri
+        case 'e': repeatInterval = offsetSeconds; break;
+        default:  break; // one-shot
+    }
+
+    addNotification(scheduledTime, repeatInterval, repeatWeekdays);
     delwin(overlayWin);
 }
 
-int main() {
+// Handle one input event. Sets needRedraw when the screen content
+// changed; clears running on quit. Split out of main() so the event
+// loop proper stays readable — and so the latency benchmark can drive
+// the exact dispatch path the user hits.
+static void dispatchKey(int ch, bool& running, bool& needRedraw) {
+    switch (ch) {
+        case 'q':
+            running = false;
+            break;
+
+        case KEY_UP:
+            if (selectedIndex > 0) {
+                selectedIndex--;
+                needRedraw = true;
+            }
+            break;
+
+        case KEY_DOWN: {
+            std::vector<int>& filteredIndices = getFilteredIndices();
+            if (selectedIndex < (int)filteredIndices.size() - 1) {
+                selectedIndex++;
+                needRedraw = true;
+            }
+        } break;
+
+        case KEY_HOME:
+            if (selectedIndex != 0) {
+                selectedIndex = 0;
+                needRedraw = true;
+            }
+            break;
+
+        case KEY_END: {
+            std::vector<int>& filteredIndices = getFilteredIndices();
+            if (!filteredIndices.empty()) {
+                selectedIndex = (int)filteredIndices.size() - 1;
+                needRedraw = true;
+            }
+        } break;
+
+        case KEY_PPAGE:
+            if (selectedIndex > 10) {
+                selectedIndex -= 10;
+            } else {
+                selectedIndex = 0;
+            }
+            needRedraw = true;
+            break;
+
+        case KEY_NPAGE: {
+            int limit = (int)getFilteredIndices().size();
+            if (selectedIndex + 10 < limit) {
+                selectedIndex += 10;
+            } else {
+                if (limit > 0) selectedIndex = limit - 1;
+                else selectedIndex = 0;
+            }
+            needRedraw = true;
+        } break;
+
+        case 'r':
+            reminderSentViaIpc = false;
+            setReminderOverlay();
+            if (!reminderSentViaIpc) {
+                // Daemon not reachable: fall back to the file round-trip
+                saveNotifications();
+            }
+            invalidateListUI();  // the overlay painted over listWin
+            needRedraw = true;
+            break;
+
+        case 'n':
+            addTaskOverlay();
+            needRedraw = true;
+            break;
+
+        case ' ': {
+            // Toggle the bulk mark on the selected row, then advance
+            std::vector<int>& filteredIndices = getFilteredIndices();
+            if (!filteredIndices.empty() &&
+                selectedIndex < (int)filteredIndices.size()) {
+                long long id =
+                    allTasks[activeView()[filteredIndices[selectedIndex]]].id;
+                if (!markedTaskIds.erase(id)) markedTaskIds.insert(id);
+                if (selectedIndex < (int)filteredIndices.size() - 1) {
+                    selectedIndex++;
+                }
+                invalidateListUI(); // the mark column changed
+                needRedraw = true;
+            }
+        } break;
+
+        case 27: // ESC clears any pending bulk marks
+            if (!markedTaskIds.empty()) {
+                markedTaskIds.clear();
+                invalidateListUI();
+                needRedraw = true;
+            }
+            break;
+
+        case 'c':
+            if (!markedTaskIds.empty()) {
+                bulkComplete();
+            } else {
+                completeTask();
+            }
+            needRedraw = true;
+            break;
+
+        case 'd':
+            if (!markedTaskIds.empty()) {
+                bulkDelete();
+            } else {
+                deleteTask();
+            }
+            needRedraw = true;
+            break;
+
+        case 'u':
+            undoMutation();
+            needRedraw = true;
+            break;
+
+        case 'U':
+            redoMutation();
+            needRedraw = true;
+            break;
+
+        case 'p':
+            perfHudEnabled = !perfHudEnabled;
+            if (!perfHudEnabled) {
+                move(LINES - 1, 0);  // clear the HUD line
+                clrtoeol();
+            }
+            needRedraw = true;
+            break;
+
+        case 'P':
+            perfDump();
+            break;
+
+        case 's': {
+            if (!markedTaskIds.empty()) {
+                bulkRecategorize();
+                invalidateListUI(); // the overlay painted over listWin
+                needRedraw = true;
+                break;
+            }
+            std::vector<int>& filteredIndices = getFilteredIndices();
+            if (!filteredIndices.empty() && selectedIndex < (int)filteredIndices.size()) {
+                int viewPos = filteredIndices[selectedIndex];
+                int oldCatId = allTasks[activeView()[viewPos]].categoryId;
+                // show overlay (it edits the master task directly)
+                addCategoryOverlay(viewPos, (viewMode == 1));
+                Task &updated = allTasks[activeView()[viewPos]];
+                touchArchived(updated);
+                if (updated.categoryId != oldCatId) {
+                    // Journal only real changes; a no-op record's fresh
+                    // sync-log timestamp could revert a peer's edit.
+                    journalAppend("G;" + std::to_string(updated.id) + ";" +
+                                  categoryName(updated.categoryId));
+                    MutationDelta delta;
+                    delta.op = 'G';
+                    delta.taskId = updated.id;
+                    delta.oldCatId = oldCatId;
+                    delta.newCatId = updated.categoryId;
+                    recordMutation(std::move(delta));
+                }
+                // Category changes can move the task in/out of the filter
+                // and change its category sort key
+                invalidateSortCaches();
+                invalidateFilterIndex();
+                needRedraw = true;
+            }
+        } break;
+
+        case '#':
+            listCategoriesOverlay();
+            invalidateFilterIndex();
+            needRedraw = true;
+            break;
+
+        case '/':
+            searchPrompt();
+            needRedraw = true;
+            break;
+
+        case 'o':
+            // Cycle the sort mode; cached orderings make this instant
+            sortMode = (sortMode + 1) % SORT_MODE_COUNT;
+            selectedIndex = 0;
+            invalidateFilterIndex();
+            needRedraw = true;
+            break;
+
+        case 'e':
+            editTask();
+            invalidateListUI();  // text changed + the overlay painted over listWin
+            needRedraw = true;
+            break;
+
+        case ':': {
+            mvprintw(LINES - 1, 0, "Goto item (blank=cancel): ");
+            clrtoeol();
+            wnoutrefresh(stdscr);
+            doupdate();
+            echo();
+            curs_set(1);
+
+            char buffer[16];
+            memset(buffer, 0, sizeof(buffer));
+            wgetnstr(stdscr, buffer, 15);
+
+            noecho();
+            curs_set(0);
+
+            std::string lineInput(buffer);
+            if (!lineInput.empty()) {
+                try {
+                    int itemNum = std::stoi(lineInput);
+                    gotoItem(itemNum);
+                    needRedraw = true;
+                } catch (...) {
+                    // ignore invalid input
+                }
+            }
+            mvprintw(LINES - 1, 0, "                                              ");
+            clrtoeol();
+            wnoutrefresh(stdscr);
+            doupdate();
+        } break;
+
+        case '\t':
+            viewMode = 1 - viewMode;
+            if (viewMode == 1) {
+                ensureArchiveLoaded(); // completed view includes the archive
+            }
+            selectedIndex = 0;
+            invalidateFilterIndex();
+            needRedraw = true;
+            break;
+
+        default:
+            break;
+    }
+}
+
+
+#ifndef TODO_BENCH  // bench.cpp includes this file and provides its own main
+
+// ---------------------------------------------------------------------------
+// Event core for the interactive loop.
+//
+// The loop blocks in poll() on stdin plus an inotify watch on the data
+// directory, so the daemon rewriting notifications.db wakes us instead of us
+// re-reading files around keystrokes. Bursts of queued input (held-key
+// autorepeat) are drained and coalesced into one repaint — the metric that
+// matters is keypress-to-paint while scrolling, and painting once per burst
+// keeps it flat no matter how fast the repeat rate is. Quiet stretches are
+// spent on background work the user would otherwise pay for later.
+// ---------------------------------------------------------------------------
+
+static const int IDLE_TIMEOUT_MS = 2000;
+
+// Swallow everything queued on the inotify fd. Returns true if
+// notifications.db was replaced — the daemon renames a temp file over it,
+// which arrives as IN_MOVED_TO.
+static bool drainInotify(int fd) {
+    static const std::string notifName =
+        NOTIFICATION_FILE.substr(NOTIFICATION_FILE.rfind('/') + 1);
+    alignas(struct inotify_event) char buf[4096];
+    bool notifChanged = false;
+    ssize_t len;
+    while ((len = read(fd, buf, sizeof(buf))) > 0) {
+        for (ssize_t off = 0; off < len;) {
+            const struct inotify_event* ev =
+                (const struct inotify_event*)(buf + off);
+            if (ev->len > 0 && notifName == ev->name) {
+                notifChanged = true;
+            }
+            off += (ssize_t)(sizeof(struct inotify_event) + ev->len);
+        }
+    }
+    return notifChanged;
+}
+
+// The daemon rewrote notifications.db: a reminder fired, or a recurring one
+// rolled forward. Reload it and refresh the per-task reminder fields via the
+// keyed store, so the reminder column shows what will actually fire next.
+static void refreshNotifications() {
+    loadNotifications();
+    bool changed = false;
+    for (Task& t : allTasks) {
+        if (t.notification.scheduledTime == 0) continue;
+        auto it = notifications.find(t.id);
+        if (it != notifications.end()) {
+            if (t.notification.scheduledTime != it->second.scheduledTime ||
+                t.notification.triggered != it->second.triggered) {
+                t.notification = it->second;
+                changed = true;
+            }
+        } else if (!t.notification.triggered) {
+            // Entry gone from the file: it fired and wasn't recurring
+            t.notification.triggered = true;
+            changed = true;
+        }
+    }
+    if (changed) {
+        // The reminder sort key moved; under SORT_REMINDER the cached
+        // permutation and filter index are stale, same as after 'r'.
+        invalidateSortCaches();
+        invalidateFilterIndex();
+        invalidateListUI();
+    }
+}
+
+// Pre-warm the layout and date-string caches for the rows just outside the
+// viewport, so the first scroll after an idle stretch hits warm caches.
+static void prewarmLayouts() {
+    if (!listWin) return;
+    int wrapWidth = (getmaxx(listWin) - 56) - 7;  // as drawListUI computes it
+    if (wrapWidth <= 0) return;
+    std::vector<int>& filteredIndices = getFilteredIndices();
+    std::vector<int>& view = activeView();
+    int rows = getmaxy(listWin) - 2;
+    if (rows < 1) rows = 1;
+    int from = std::max(0, selectedIndex - rows);
+    int to = std::min((int)filteredIndices.size(), selectedIndex + 3 * rows);
+    for (int i = from; i < to; i++) {
+        const Task& t = allTasks[view[filteredIndices[i]]];
+        (void)getTaskLayout(t, wrapWidth);
+        (void)getDateStrings(t);
+    }
+}
+
+// Runs when poll() times out with nothing pending. One unit of work per
+// tick, cheapest-to-skip first, so we never hold the loop long enough for
+// the user to notice a delayed keystroke.
+static void idleWork() {
+    if (journalRecordsSinceCompact > 0) {
+        // Fold the journal into the snapshot now; quitting (or crashing and
+        // replaying) later then has nothing left to do.
+        journalCompact();
+        return;
+    }
+    prewarmLayouts();
+}
+
+int main(int argc, char** argv) {
+    // Headless subcommands; no ncurses, safe to run from cron, hooks or ssh.
+    if (argc > 1) {
+        std::string cmd = argv[1];
+        if (cmd == "add") {
+            return runCliAdd(argc, argv);
+        }
+        if (cmd == "done") {
+            return runCliDone(argc, argv);
+        }
+        if (cmd == "list") {
+            return runCliList(argc, argv);
+        }
+        if (cmd == "sync") {
+            return runSyncClient(argc > 2 ? argv[2] : "");
+        }
+        if (cmd == "sync-serve") {
+            return runSyncServer(argc > 2 ? atoi(argv[2]) : SYNC_DEFAULT_PORT);
+        }
+        if (cmd == "sync-stdio") {
+            return syncSession(stdin, stdout, false);
+        }
+        fprintf(stderr,
+                "usage: todo                 interactive UI\n"
+                "       todo add <text> [--category=X]\n"
+                "       todo done <number|text substring>\n"
+                "       todo list [--done] [--category=X]\n"
+                "       todo sync <host>[:port] | sync ssh:<host>\n"
+                "       todo sync-serve [port]\n"
+                "       todo sync-stdio     (used by sync ssh:)\n");
+        return 1;
+    }
+
     initscr();
     cbreak();
     noecho();
@@ -864,213 +3550,99 @@ int main() {
     // Load notifications first
     loadNotifications();
     allTasks = loadTasksFromFile();
-    filterTasks(allTasks);
+    // Replay any mutations journaled since the last snapshot; if there were
+    // any, fold them in now so the journal starts the session empty.
+    if (journalReplay(allTasks)) {
+        assignMissingTaskIds(allTasks);
+        invalidateTaskIndex();
+        journalCompact();
+    }
+    rebuildViews();
+    rebuildSearchIndex();
+
+    // All further journal writes happen off the UI thread.
+    startJournalThread();
 
     selectedIndex = 0;
     drawUI();
     doupdate();
 
-    while (true) {
-        int ch = wgetch(stdscr);
-        bool needRedraw = false;
-        loadNotifications();
-        switch (ch) {
-            case 'q':
-                // Save all tasks + notifications
-                saveTasks();
-                loadNotifications();
-                saveNotifications();
-                delwin(listWin);
-                endwin();
-                return 0;
-
-            case KEY_UP:
-                if (selectedIndex > 0) {
-                    selectedIndex--;
-                    needRedraw = true;
-                }
-                break;
-
-            case KEY_DOWN: {
-                const std::vector<Task> &temp = (viewMode == 0) ? currentTasks : completedTasks;
-                // build filtered indices
-                std::vector<int> filteredIndices;
-                for (int i = 0; i < (int)temp.size(); i++) {
-                    if (activeFilterCategory == "All" || temp[i].category == activeFilterCategory) {
-                        filteredIndices.push_back(i);
-                    }
-                }
-                if (selectedIndex < (int)filteredIndices.size() - 1) {
-                    selectedIndex++;
-                    needRedraw = true;
-                }
-            } break;
-
-            case KEY_HOME:
-                if (selectedIndex != 0) {
-                    selectedIndex = 0;
-                    needRedraw = true;
-                }
-                break;
-
-            case KEY_END: {
-                const std::vector<Task> &temp = (viewMode == 0) ? currentTasks : completedTasks;
-                std::vector<int> filteredIndices;
-                for (int i = 0; i < (int)temp.size(); i++) {
-                    if (activeFilterCategory == "All" || temp[i].category == activeFilterCategory) {
-                        filteredIndices.push_back(i);
-                    }
-                }
-                if (!filteredIndices.empty()) {
-                    selectedIndex = (int)filteredIndices.size() - 1;
-                    needRedraw = true;
-                }
-            } break;
-
-            case KEY_PPAGE:
-                if (selectedIndex > 10) {
-                    selectedIndex -= 10;
-                } else {
-                    selectedIndex = 0;
-                }
-                needRedraw = true;
-                break;
-
-            case KEY_NPAGE: {
-                const std::vector<Task> &temp = (viewMode == 0) ? currentTasks : completedTasks;
-                std::vector<int> filteredIndices;
-                for (int i = 0; i < (int)temp.size(); i++) {
-                    if (activeFilterCategory == "All" || temp[i].category == activeFilterCategory) {
-                        filteredIndices.push_back(i);
-                    }
-                }
-                int limit = (int)filteredIndices.size();
-                if (selectedIndex + 10 < limit) {
-                    selectedIndex += 10;
-                } else {
-                    if (limit > 0) selectedIndex = limit - 1;
-                    else selectedIndex = 0;
-                }
-                needRedraw = true;
-            } break;
-
-            case 'r': 
-                setReminderOverlay();
-                saveNotifications();
-                needRedraw = true;
-                break;
-
-            case 'n':
-                addTaskOverlay();
-                needRedraw = true;
-                break;
-
-            case 'c':
-                completeTask();
-                needRedraw = true;
-                break;
-
-            case 'd':
-                deleteTask();
-                needRedraw = true;
-                break;
+    // The daemon's rewrites of notifications.db arrive as inotify events;
+    // if the watch can't be set up, degrade to input + idle ticks only.
+    int inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd >= 0 &&
+        inotify_add_watch(inotifyFd, dataDir().c_str(),
+                          IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        close(inotifyFd);
+        inotifyFd = -1;
+    }
 
-            case 's': {
-                const std::vector<Task> &temp = (viewMode == 0) ? currentTasks : completedTasks;
-                std::vector<int> filteredIndices;
-                for (int i = 0; i < (int)temp.size(); i++) {
-                    if (activeFilterCategory == "All" || temp[i].category == activeFilterCategory) {
-                        filteredIndices.push_back(i);
-                    }
-                }
-                if (!filteredIndices.empty() && selectedIndex < (int)filteredIndices.size()) {
-                    int realIndex = filteredIndices[selectedIndex];
-                    // show overlay
-                    addCategoryOverlay(realIndex, (viewMode == 1));
-                    // Also update allTasks so we don't lose the new category
-                    if (viewMode == 0) {
-                        // current
-                        // find pointer
-                        Task &updated = currentTasks[realIndex];
-                        for (auto &A : allTasks) {
-                            if (A.dates[0] == updated.dates[0] &&
-                                A.task == updated.task) {
-                                A.category = updated.category;
-                            }
-                        }
-                    } else {
-                        // completed
-                        Task &updated = completedTasks[realIndex];
-                        for (auto &A : allTasks) {
-                            if (A.dates[0] == updated.dates[0] &&
-                                A.task == updated.task) {
-                                A.category = updated.category;
-                            }
-                        }
-                    }
-                    needRedraw = true;
-                }
-            } break;
+    bool running = true;
+    while (running) {
+        struct pollfd fds[2];
+        fds[0].fd = STDIN_FILENO;
+        fds[0].events = POLLIN;
+        fds[0].revents = 0;
+        fds[1].fd = inotifyFd;
+        fds[1].events = POLLIN;
+        fds[1].revents = 0;
+        int nfds = (inotifyFd >= 0) ? 2 : 1;
+
+        int ready = poll(fds, nfds, IDLE_TIMEOUT_MS);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (ready == 0) {
+            idleWork();
+            continue;
+        }
 
-            case '#':
-                listCategoriesOverlay();
-                needRedraw = true;
-                break;
+        bool needRedraw = false;
+        long long frameStart = 0;
 
-            case 'e':
-                editTask();
-                needRedraw = true;
-                break;
+        if (nfds == 2 && (fds[1].revents & POLLIN) && drainInotify(inotifyFd)) {
+            refreshNotifications();
+            needRedraw = true;
+        }
 
-            case ':': {
-                mvprintw(LINES - 1, 0, "Goto item (blank=cancel): ");
-                clrtoeol();
-                wnoutrefresh(stdscr);
-                doupdate();
-                echo();
-                curs_set(1);
-
-                char buffer[16];
-                memset(buffer, 0, sizeof(buffer));
-                wgetnstr(stdscr, buffer, 15);
-
-                noecho();
-                curs_set(0);
-
-                std::string lineInput(buffer);
-                if (!lineInput.empty()) {
-                    try {
-                        int itemNum = std::stoi(lineInput);
-                        gotoItem(itemNum);
-                        needRedraw = true;
-                    } catch (...) {
-                        // ignore invalid input
-                    }
+        if (fds[0].revents & POLLIN) {
+            int ch = wgetch(stdscr);  // poll said readable; won't block
+            while (running && ch != ERR) {
+                if (frameStart == 0) {
+                    frameStart = perfNowUs();  // keypress-to-paint starts here
                 }
-                mvprintw(LINES - 1, 0, "                                              ");
-                clrtoeol();
-                wnoutrefresh(stdscr);
-                doupdate();
-            } break;
-
-            case '\t':
-                viewMode = 1 - viewMode;
-                selectedIndex = 0;
-                needRedraw = true;
-                break;
-
-            default:
-                break;
+                dispatchKey(ch, running, needRedraw);
+                if (!running) break;
+                // Drain whatever else is already queued before painting.
+                // Handlers run with stdscr blocking (overlays and wgetnstr
+                // depend on that), so only this peek is non-blocking.
+                nodelay(stdscr, TRUE);
+                ch = wgetch(stdscr);
+                nodelay(stdscr, FALSE);
+            }
         }
 
-        if (needRedraw) {
+        if (running && needRedraw) {
             drawUI();
             doupdate();
+            if (frameStart != 0) {
+                perfRings[PERF_FRAME].add(perfNowUs() - frameStart);
+            }
         }
     }
 
+    // Archive old completed tasks, then compact the journal into the
+    // snapshot + save notifications
+    stopJournalThread();
+    archiveSweep();
+    journalCompact();
+    loadNotifications();
+    saveNotifications();
+    if (inotifyFd >= 0) close(inotifyFd);
     delwin(listWin);
     endwin();
     return 0;
 }
+#endif // TODO_BENCH
 
@@ -2,71 +2,481 @@
 #include <fstream>
 #include <sstream>
 #include <vector>
+#include <queue>
+#include <deque>
 #include <string>
-#include <chrono>
 #include <thread>
-#include <cstdlib>    // for system()
+#include <mutex>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
 #include <ctime>      // for time()
 
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/epoll.h>
+#include <sys/file.h>
+#include <sys/inotify.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
-// TODO: inotify + epoll. Waits for file modification.
+#include "record_schema.h"
+
+extern char **environ;
+
+// Event-driven design: the notifications DB is loaded once, an inotify watch
+// on its directory tells us when the TUI rewrites it, and pending entries sit
+// in a min-heap keyed on scheduledTime. The process sleeps in epoll_wait
+// until exactly the next deadline (or forever if nothing is pending) instead
+// of re-reading and re-parsing the whole file every second.
 
 // Path to the file storing scheduled notifications.
 // Make sure your service has permission to read/write this file.
 
 static const std::string NOTIFICATION_FILE = "/var/lib/todo/notifications.db";
-// A simple struct to hold notification data
-struct Notification {
-    long long scheduledTime; // epoch timestamp when to trigger
-    bool triggered;          // has the notification been sent?
-    std::string message;     // the notification text
-};
+static const std::string NOTIFICATION_DIR  = "/var/lib/todo";
+static const std::string DAEMON_SOCKET     = "/var/lib/todo/todo.sock";
+static const std::string LOCK_FILE         = "/var/lib/todo/todo.lock";
+static const std::string WATERMARK_FILE    = "/var/lib/todo/todo.watermark";
+
+// Deadlines this far in the past are treated as "came due while we weren't
+// running/awake" and reported as one overdue batch instead of a popup burst.
+static const long long OVERDUE_GRACE_SECONDS = 120;
+
+// Same locking protocol as the TUI: flock on the sidecar lock file (never
+// the data file itself — the rename-swap below replaces inodes).
+static int acquireDataLock(int op) {
+    int fd = open(LOCK_FILE.c_str(), O_RDONLY | O_CREAT, 0664);
+    if (fd >= 0) flock(fd, op);
+    return fd;
+}
+
+static void releaseDataLock(int fd) {
+    if (fd >= 0) close(fd); // closing drops the flock
+}
+
+// Crash-safe replacement of NOTIFICATION_FILE: temp file in the same
+// directory, fsync, rename over the original. Mirrors the TUI's writer so
+// neither process can ever leave the other a half-written file.
+static bool atomicWriteFile(const std::string& path, const std::string& buf) {
+    std::string tmp = path + ".tmp";
+    int fd = open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0664);
+    if (fd < 0) return false;
+
+    size_t off = 0;
+    while (off < buf.size()) {
+        ssize_t n = write(fd, buf.data() + off, buf.size() - off);
+        if (n <= 0) {
+            close(fd);
+            unlink(tmp.c_str());
+            return false;
+        }
+        off += (size_t)n;
+    }
+    if (fsync(fd) != 0) {
+        close(fd);
+        unlink(tmp.c_str());
+        return false;
+    }
+    close(fd);
+
+    if (rename(tmp.c_str(), path.c_str()) != 0) {
+        unlink(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+// The Notification struct and its line layout live in record_schema.h — the
+// same field list the TUI compiles against, so the two sides cannot drift.
 
 // Helper function to load all notifications from file
 std::vector<Notification> loadNotifications() {
     std::vector<Notification> notifs;
+    int lock = acquireDataLock(LOCK_SH);
     std::ifstream inFile(NOTIFICATION_FILE);
     if (!inFile.is_open()) {
         // If file can't be opened, return empty vector
+        releaseDataLock(lock);
         return notifs;
     }
 
     std::string line;
     while (std::getline(inFile, line)) {
         if (line.empty()) continue;
-        std::stringstream ss(line);
-        std::string part;
-
         Notification n;
-        // Format: epoch_timestamp;triggered_flag;message
-        if (std::getline(ss, part, ';')) {
-            n.scheduledTime = std::stoll(part);
-        }
-        if (std::getline(ss, part, ';')) {
-            n.triggered = (part == "1");
-        }
-        if (std::getline(ss, part)) {
-            n.message = part;
+        // Anything without at least the timestamp and triggered flag is a
+        // torn/garbled line; skip it and keep the rest of the file.
+        if (schema::parseTextRecord(line, n, schema::NOTIFICATION_FIELDS,
+                                    n.message) < 2) {
+            continue;
         }
+        if (n.scheduledTime == 0) continue;  // cancelled
         notifs.push_back(n);
     }
     inFile.close();
+    releaseDataLock(lock);
     return notifs;
 }
 
 // Helper function to save all notifications back to file
 void saveNotifications(const std::vector<Notification>& notifs) {
-    std::ofstream outFile(NOTIFICATION_FILE, std::ios::trunc); // overwrite
-    if (!outFile.is_open()) {
+    std::string out;
+    for (auto &n : notifs) {
+        if (n.scheduledTime == 0) continue;  // cancelled; drop the line
+        schema::formatTextRecord(out, n, schema::NOTIFICATION_FIELDS,
+                                 n.message);
+        out += '\n';
+    }
+    int lock = acquireDataLock(LOCK_EX);
+    bool ok = atomicWriteFile(NOTIFICATION_FILE, out);
+    releaseDataLock(lock);
+    if (!ok) {
         std::cerr << "ERROR: Unable to write to " << NOTIFICATION_FILE << std::endl;
-        return;
     }
-    for (auto &n : notifs) {
-        outFile << n.scheduledTime << ";"
-                << (n.triggered ? "1" : "0") << ";"
-                << n.message << "\n";
+}
+
+// Last-processed watermark: every deadline at or before this instant has
+// been dispatched (or deliberately suppressed). Persisted so a restart can
+// tell "came due while we were down" apart from "already handled before a
+// crash that beat the notifications.db save". Daemon-private file, so no
+// flock needed — only the rename has to be atomic.
+static long long loadWatermark() {
+    std::ifstream in(WATERMARK_FILE);
+    long long wm = 0;
+    if (in >> wm) return wm;
+    return 0;
+}
+
+static void saveWatermark(long long wm) {
+    atomicWriteFile(WATERMARK_FILE, std::to_string(wm) + "\n");
+}
+
+// Does the recurrence rule allow firing on the (local) day of `when`?
+static bool weekdayAllowed(const Notification& n, long long when) {
+    if (n.repeatWeekdays == 0) return true;
+    time_t t = (time_t)when;
+    struct tm tmBuf;
+    localtime_r(&t, &tmBuf);
+    return (n.repeatWeekdays >> tmBuf.tm_wday) & 1;
+}
+
+// Next occurrence strictly after `now` that the weekday mask allows. Only
+// this single occurrence is ever materialized into the pending heap;
+// notifications.db stays one line per rule no matter how long it recurs.
+static long long nextOccurrence(const Notification& n, long long now) {
+    if (n.repeatInterval <= 0) return 0;
+
+    // Jump the whole gap in one division — stepping an "every 60s" rule
+    // interval-by-interval would exhaust any iteration guard after a few
+    // days of suspend and silently kill a perfectly valid rule.
+    long long base = (now > n.scheduledTime) ? now : n.scheduledTime;
+    long long next = n.scheduledTime +
+        ((base - n.scheduledTime) / n.repeatInterval + 1) * n.repeatInterval;
+
+    // Weekday scan: a disallowed day is skipped whole (on to the first grid
+    // point past its last second), so eight steps reach every satisfiable
+    // mask and falling out means no days are set at all.
+    for (int guard = 0; guard < 8; guard++) {
+        if (weekdayAllowed(n, next)) return next;
+        time_t t = (time_t)next;
+        struct tm tmBuf;
+        localtime_r(&t, &tmBuf);
+        tmBuf.tm_hour = 23;
+        tmBuf.tm_min = 59;
+        tmBuf.tm_sec = 59;
+        long long dayEnd = (long long)mktime(&tmBuf);
+        if (dayEnd < next) break; // mktime failure; don't loop on it
+        next += ((dayEnd - next) / n.repeatInterval + 1) * n.repeatInterval;
+    }
+    return 0; // rule can never fire (weekday mask with no days set)
+}
+
+// Min-heap of (scheduledTime, index into notifs) so the next deadline is
+// always at the top. Indices go stale when the file is reloaded, so the heap
+// is rebuilt together with the vector.
+typedef std::pair<long long, size_t> PendingEntry;
+typedef std::priority_queue<PendingEntry,
+                            std::vector<PendingEntry>,
+                            std::greater<PendingEntry>> PendingHeap;
+
+static PendingHeap buildPendingHeap(const std::vector<Notification>& notifs) {
+    PendingHeap heap;
+    for (size_t i = 0; i < notifs.size(); i++) {
+        if (!notifs[i].triggered) {
+            heap.push({notifs[i].scheduledTime, i});
+        }
+    }
+    return heap;
+}
+
+// ---------------------------------------------------------------------------
+// Async dispatch stage.
+//
+// notify-send used to be run through system() inside the scan loop: a shell
+// fork per notification, serialized, blocking the loop — several reminders
+// landing in the same second queued up behind each other. Due messages are
+// now collected into a batch and handed to a worker thread that spawns
+// notify-send directly via posix_spawnp (no shell). Marking triggered and
+// persisting the file happen immediately on the main thread, so one slow or
+// hung desktop-notification daemon can't delay or drop the rest.
+// ---------------------------------------------------------------------------
+
+static std::deque<std::string> dispatchQueue;
+static std::mutex dispatchMutex;
+static std::condition_variable dispatchCv;
+
+static void dispatchWorker() {
+    while (true) {
+        std::vector<std::string> batch;
+        {
+            std::unique_lock<std::mutex> lock(dispatchMutex);
+            dispatchCv.wait(lock, [] { return !dispatchQueue.empty(); });
+            batch.assign(dispatchQueue.begin(), dispatchQueue.end());
+            dispatchQueue.clear();
+        }
+
+        // Spawn the whole batch first, then reap, so the sends overlap.
+        std::vector<pid_t> pids;
+        for (auto &message : batch) {
+            const char* argv[] = {"notify-send", "~@~TODO!~@~",
+                                  message.c_str(), nullptr};
+            pid_t pid;
+            if (posix_spawnp(&pid, "notify-send", nullptr, nullptr,
+                             const_cast<char* const*>(argv), environ) == 0) {
+                pids.push_back(pid);
+            }
+        }
+        for (pid_t pid : pids) {
+            int status;
+            waitpid(pid, &status, 0);
+        }
+    }
+}
+
+static void enqueueDispatch(std::vector<std::string>& batch) {
+    if (batch.empty()) return;
+    {
+        std::lock_guard<std::mutex> lock(dispatchMutex);
+        for (auto &m : batch) {
+            dispatchQueue.push_back(std::move(m));
+        }
+    }
+    dispatchCv.notify_one();
+}
+
+// Fire everything at the heap top that is due. Returns true if any
+// notification was triggered (and thus the file needs saving).
+//
+// Three classes of due entry:
+//   - fresh (due within the grace window): one popup each, as always
+//   - overdue (suspend, restart, long downtime): collected into a single
+//     summary popup so waking a laptop doesn't unleash a popup burst
+//   - at or before the watermark: a previous run already dispatched these
+//     but died before saving notifications.db; retire them silently
+// Recurring rules roll forward in every class.
+static bool fireDue(std::vector<Notification>& notifs, PendingHeap& heap,
+                    long long watermark) {
+    auto now = static_cast<long long>(std::time(nullptr));
+    bool updated = false;
+
+    std::vector<std::string> batch;
+    std::vector<std::string> overdue;
+    while (!heap.empty() && heap.top().first <= now) {
+        long long when = heap.top().first;
+        size_t idx = heap.top().second;
+        heap.pop();
+        if (idx >= notifs.size() || notifs[idx].triggered) continue;
+        // Stale heap entry from before a reschedule; the live one is
+        // elsewhere in the heap.
+        if (when != notifs[idx].scheduledTime) continue;
+
+        if (when <= watermark) {
+            // already dispatched in a previous life
+        } else if (when <= now - OVERDUE_GRACE_SECONDS) {
+            overdue.push_back(notifs[idx].message);
+        } else {
+            batch.push_back(notifs[idx].message);
+        }
+        if (notifs[idx].repeatInterval > 0) {
+            // Recurring rule: roll forward to the next allowed occurrence
+            // and re-queue it instead of retiring the entry.
+            long long next = nextOccurrence(notifs[idx], now);
+            if (next > 0) {
+                notifs[idx].scheduledTime = next;
+                heap.push({next, idx});
+            } else {
+                notifs[idx].triggered = true;
+            }
+        } else {
+            notifs[idx].triggered = true;
+        }
+        updated = true;
+    }
+
+    if (overdue.size() == 1) {
+        batch.push_back("(overdue) " + overdue[0]);
+    } else if (!overdue.empty()) {
+        std::string combined =
+            std::to_string(overdue.size()) + " overdue reminders: ";
+        for (size_t i = 0; i < overdue.size(); i++) {
+            if (i) combined += " | ";
+            if (combined.size() > 300) {
+                combined += "...";
+                break;
+            }
+            combined += overdue[i];
+        }
+        batch.push_back(combined);
+    }
+    enqueueDispatch(batch);
+    return updated;
+}
+
+// ---------------------------------------------------------------------------
+// IPC listener.
+//
+// The TUI pushes reminder events over this unix socket instead of rewriting
+// notifications.db and hoping we notice. One short-lived SEQPACKET
+// connection per event; messages are tiny and acked with "OK"/"ERR".
+//
+//   ADD;<scheduledTime>;<interval>;<weekdays>;<taskId>;<message>
+//       schedule a notification; interval 0 / weekdays 0 means one-shot.
+//       A second ADD with the same task id replaces the first (reschedule).
+//   CANCEL;<taskId>
+//       forget the task's notification
+//   SNOOZE;<taskId>;<seconds>
+//       push the task's notification <seconds> into the future and
+//       re-queue it, reviving an already-fired one-shot if needed
+// ---------------------------------------------------------------------------
+
+static int setupIpcSocket() {
+    unlink(DAEMON_SOCKET.c_str()); // stale socket from a previous run
+
+    int fd = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+    if (fd < 0) return -1;
+
+    struct sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, DAEMON_SOCKET.c_str(), sizeof(addr.sun_path) - 1);
+
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+        listen(fd, 4) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Handle one client connection. Returns true if the notification set
+// changed (and thus needs persisting).
+static bool handleIpcClient(int listenFd, std::vector<Notification>& notifs,
+                            PendingHeap& heap) {
+    int clientFd = accept(listenFd, nullptr, nullptr);
+    if (clientFd < 0) return false;
+
+    // Never let a stalled client hang the event loop — the TUI uses the
+    // same 1s deadline on its end of the socket.
+    struct timeval tv = {1, 0};
+    setsockopt(clientFd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(clientFd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+    char buf[4096];
+    ssize_t len = recv(clientFd, buf, sizeof(buf) - 1, 0);
+    bool changed = false;
+    bool ok = false;
+
+    if (len > 0) {
+        buf[len] = '\0';
+        std::string msg(buf);
+        if (msg.rfind("ADD;", 0) == 0) {
+            size_t sep = msg.find(';', 4);
+            if (sep != std::string::npos) {
+                Notification n;
+                try {
+                    n.scheduledTime = std::stoll(msg.substr(4, sep - 4));
+                    n.triggered = false;
+                    schema::parseTextRecord<schema::NOTIFICATION_TAIL_FIELD>(
+                        msg.substr(sep + 1), n, schema::NOTIFICATION_FIELDS,
+                        n.message);
+                    // Reschedule: replace any entry keyed to the same task,
+                    // in place — erasing would dangle heap indices. The old
+                    // heap entry no longer matches scheduledTime, so the
+                    // staleness check drops it on pop.
+                    size_t idx = notifs.size();
+                    if (n.taskId != 0) {
+                        for (size_t i = 0; i < notifs.size(); i++) {
+                            if (notifs[i].taskId == n.taskId) {
+                                idx = i;
+                                break;
+                            }
+                        }
+                    }
+                    if (idx == notifs.size()) {
+                        notifs.push_back(n);
+                    } else {
+                        notifs[idx] = n;
+                    }
+                    heap.push({n.scheduledTime, idx});
+                    changed = true;
+                    ok = true;
+                } catch (...) {
+                }
+            }
+        } else if (msg.rfind("CANCEL;", 0) == 0) {
+            try {
+                long long id = std::stoll(msg.substr(7));
+                for (auto &n : notifs) {
+                    if (n.taskId == id && n.scheduledTime != 0) {
+                        // Zero the deadline in place: pending heap entries
+                        // stop matching and the next save drops the line.
+                        n.scheduledTime = 0;
+                        n.triggered = true;
+                        changed = true;
+                    }
+                }
+                ok = true;  // cancelling a non-existent entry is fine
+            } catch (...) {
+            }
+        } else if (msg.rfind("SNOOZE;", 0) == 0) {
+            size_t sep = msg.find(';', 7);
+            if (sep != std::string::npos) {
+                try {
+                    long long id = std::stoll(msg.substr(7, sep - 7));
+                    long long secs = std::stoll(msg.substr(sep + 1));
+                    long long when =
+                        static_cast<long long>(std::time(nullptr)) + secs;
+                    for (size_t i = 0; i < notifs.size(); i++) {
+                        if (notifs[i].taskId != id) continue;
+                        notifs[i].scheduledTime = when;
+                        notifs[i].triggered = false;
+                        heap.push({when, i});  // old entries fall out on pop
+                        changed = true;
+                        ok = true;
+                    }
+                } catch (...) {
+                }
+            }
+        }
     }
-    outFile.close();
+
+    const char* reply = ok ? "OK" : "ERR";
+    send(clientFd, reply, strlen(reply), 0);
+    close(clientFd);
+    return changed;
+}
+
+// epoll timeout in milliseconds until the next deadline, or -1 (block
+// forever) when nothing is pending.
+static int nextTimeoutMs(const PendingHeap& heap) {
+    if (heap.empty()) return -1;
+    auto now = static_cast<long long>(std::time(nullptr));
+    long long delta = heap.top().first - now;
+    if (delta <= 0) return 0;
+    if (delta > 3600) delta = 3600; // re-check hourly as a clock-jump guard
+    return (int)(delta * 1000);
 }
 
 int main() {
@@ -78,34 +488,117 @@ int main() {
         // Just ensure file exists. Do nothing else.
     }
 
+    // Watch the directory, not the file: the TUI rewrites notifications.db
+    // with truncate, and a directory watch survives that as well as any
+    // future rename-in-place save.
+    int inotifyFd = inotify_init1(IN_NONBLOCK);
+    if (inotifyFd < 0) {
+        std::cerr << "ERROR: inotify_init1 failed: " << strerror(errno) << std::endl;
+        return 1;
+    }
+    int watchFd = inotify_add_watch(inotifyFd, NOTIFICATION_DIR.c_str(),
+                                    IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (watchFd < 0) {
+        std::cerr << "ERROR: inotify_add_watch failed on " << NOTIFICATION_DIR
+                  << ": " << strerror(errno) << std::endl;
+        return 1;
+    }
+
+    int epollFd = epoll_create1(0);
+    if (epollFd < 0) {
+        std::cerr << "ERROR: epoll_create1 failed: " << strerror(errno) << std::endl;
+        return 1;
+    }
+    struct epoll_event ev;
+    std::memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = inotifyFd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, inotifyFd, &ev);
+
+    // IPC socket for events pushed directly by the TUI.
+    int ipcFd = setupIpcSocket();
+    if (ipcFd >= 0) {
+        std::memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN;
+        ev.data.fd = ipcFd;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, ipcFd, &ev);
+    } else {
+        std::cerr << "WARNING: could not bind " << DAEMON_SOCKET
+                  << "; falling back to file watching only" << std::endl;
+    }
+
+    // Worker thread owning all notify-send spawning.
+    std::thread worker(dispatchWorker);
+    worker.detach();
+
+    // Load once; afterwards only inotify events trigger a reload. The first
+    // pass through the loop fires anything that came due since the watermark
+    // as an overdue batch.
+    auto notifs = loadNotifications();
+    PendingHeap heap = buildPendingHeap(notifs);
+    long long watermark = loadWatermark();
+
     while (true) {
-        // Load notifications
-        auto notifs = loadNotifications();
-
-        // Current epoch time
-        auto now = static_cast<long long>(std::time(nullptr));
-        bool updated = false;
-
-        // Check each notification
-        for (auto &n : notifs) {
-            // If not triggered and time has come
-            if (!n.triggered && (n.scheduledTime <= now && n.scheduledTime > (now - 2))) {
-                // Send the notification (using notify-send)
-                std::string command = "notify-send '~@~TODO!~@~' '" + n.message + "'";
-                system(command.c_str());
-                n.triggered = true;
-                updated = true;
+        struct epoll_event events[4];
+        int n = epoll_wait(epollFd, events, 4, nextTimeoutMs(heap));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "ERROR: epoll_wait failed: " << strerror(errno) << std::endl;
+            break;
+        }
+
+        bool reload = false;
+        bool ipcPending = false;
+        for (int i = 0; i < n; i++) {
+            if (ipcFd >= 0 && events[i].data.fd == ipcFd) {
+                ipcPending = true;
+                continue;
+            }
+            if (events[i].data.fd != inotifyFd) continue;
+            // Drain the inotify queue; we only care whether our file changed.
+            char buf[4096];
+            ssize_t len;
+            while ((len = read(inotifyFd, buf, sizeof(buf))) > 0) {
+                ssize_t off = 0;
+                while (off < len) {
+                    auto* ie = reinterpret_cast<struct inotify_event*>(buf + off);
+                    if (ie->len > 0 && NOTIFICATION_FILE.compare(
+                            NOTIFICATION_DIR.size() + 1, std::string::npos,
+                            ie->name) == 0) {
+                        reload = true;
+                    }
+                    off += sizeof(struct inotify_event) + ie->len;
+                }
             }
         }
 
-        // If we triggered any new notifications, save them
-        if (updated) {
+        // Reload before accepting a client: both arrive in one batch
+        // routinely (our own saveNotifications rename queues an IN_MOVED_TO
+        // drained on the next wake). An IPC mutation applied first would be
+        // wiped by the reload after we already acked OK — and the TUI,
+        // trusting the ack, skipped its own fallback write.
+        if (reload) {
+            notifs = loadNotifications();
+            heap = buildPendingHeap(notifs);
+        }
+        if (ipcPending && handleIpcClient(ipcFd, notifs, heap)) {
+            // Persist entries the TUI pushed over the socket.
             saveNotifications(notifs);
         }
 
-        // Sleep some seconds before checking again
-        std::this_thread::sleep_for(std::chrono::seconds(1));
+        // Fire whatever is due (on timeout expiry, or newly-due entries from
+        // a reload/push). If we triggered any, advance the watermark first —
+        // it is the cheap write, so a crash mid-save re-suppresses rather
+        // than re-fires — then persist the flags.
+        long long processedUpTo = static_cast<long long>(std::time(nullptr));
+        if (fireDue(notifs, heap, watermark)) {
+            watermark = processedUpTo;
+            saveWatermark(watermark);
+            saveNotifications(notifs);
+        }
     }
 
+    close(epollFd);
+    close(inotifyFd);
     return 0;
 }